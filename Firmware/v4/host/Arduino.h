@@ -0,0 +1,205 @@
+/*********************************************************************
+ * ホストビルド用 Arduino 互換シム
+ * ---------------------------------------------------------------
+ * v4ファームウェア(main.cpp)をそのままPC上でコンパイルし、
+ * シミュレーション/リプレイ/ベンチマークから駆動するための最小実装。
+ * 時刻・ピン・熱電対・EEPROM・シリアルは全て host:: 名前空間から操作する。
+ *********************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <cmath>
+#include <type_traits>
+
+using std::isnan;
+
+/* ================= 基本定義 ================= */
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+// ATmega32U4 (Pro Micro) のアナログピン番号
+#define A0 18
+#define A1 19
+#define A2 20
+#define A3 21
+#define A4 22
+#define A5 23
+#define A6 24
+#define A7 25
+#define A8 26
+#define A9 27
+#define A10 28
+#define A11 29
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(p)  (*reinterpret_cast<const uint8_t *>(p))
+#define pgm_read_word(p)  (*reinterpret_cast<const uint16_t *>(p))
+#define pgm_read_dword(p) (*reinterpret_cast<const uint32_t *>(p))
+#define pgm_read_float(p) (*reinterpret_cast<const float *>(p))
+#define pgm_read_ptr(p)   (*reinterpret_cast<const void * const *>(p))
+#define memcpy_P  memcpy
+#define strcpy_P  strcpy
+#define strncpy_P strncpy
+#define strlen_P  strlen
+#define strcmp_P  strcmp
+#define strcat_P  strcat
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+// Arduinoのmin/maxマクロ相当（<algorithm>と衝突しないようテンプレートで実装）
+template <class A, class B> inline typename std::common_type<A, B>::type min(A a, B b) { return (a < b) ? a : b; }
+template <class A, class B> inline typename std::common_type<A, B>::type max(A a, B b) { return (a > b) ? a : b; }
+template <class T, class L, class H> inline T constrain(T v, L lo, H hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// リセット要因（MCUSR）
+#define PORF  0
+#define EXTRF 1
+#define BORF  2
+#define WDRF  3
+#define MCUSR (host::state().mcusr)
+
+/* ================= ホスト側の状態 ================= */
+namespace host {
+    constexpr uint8_t PIN_CNT = 32;
+    constexpr uint16_t EEPROM_SIZE = 1024; // ATmega32U4
+
+    struct State {
+        uint32_t ms;                  // 仮想millis()
+        uint32_t us;                  // 仮想micros()
+        uint8_t  pinMode[PIN_CNT];
+        uint8_t  pinOut[PIN_CNT];     // digitalWriteされた値
+        uint8_t  pinIn[PIN_CNT];      // digitalReadで返す値
+        uint16_t analog[PIN_CNT];     // analogReadで返す値
+        float    thermoC[PIN_CNT];    // CSピンごとの熱電対温度（NaNで断線）
+        uint8_t  thermoFault[PIN_CNT];// CSピンごとの熱電対の故障注入（SPI.hのhost::TcFault）
+        uint8_t  tcChip;              // 熱電対アンプの品種（Config::Thermo::Chipと同じ番号、0:MAX6675）
+        uint32_t tcConvMs[PIN_CNT];   // 熱電対アンプの変換開始時刻
+        uint8_t  tcReg[PIN_CNT][16];  // 熱電対アンプの内部レジスタ（変換結果とMAX31856の設定）
+        uint8_t  spiCs;               // 最後にLOWにされたピン（SPIモックのチップセレクト判定用）
+        uint8_t  eeprom[EEPROM_SIZE];
+        uint32_t eepromWrites;        // 実際に値が変化したバイト書き込み数
+        uint16_t (*analogHook)(uint8_t pin); // 指定時はanalogReadをフック
+        uint8_t  mcusr;               // リセット要因レジスタ
+    };
+
+    static State &state() { static State s; return s; }
+
+    // 全状態を電源投入直後相当に戻す（EEPROMは未書き込みの0xFF）
+    static void powerOn() {
+        State &s = state();
+        memset(&s, 0, sizeof(s));
+        memset(s.eeprom, 0xFF, sizeof(s.eeprom));
+        s.mcusr = 1 << PORF;
+        for (uint8_t i = 0; i < PIN_CNT; i++) { s.pinIn[i] = HIGH; s.thermoC[i] = 25.0f; }
+    }
+
+    static void advance(uint32_t ms) { state().ms += ms; state().us += ms * 1000UL; }
+}
+
+inline uint32_t millis() { return host::state().ms; }
+inline uint32_t micros() { return host::state().us; }
+inline void delay(uint32_t ms) { host::advance(ms); }
+inline void delayMicroseconds(uint16_t us) { host::state().us += us; }
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < host::PIN_CNT) host::state().pinMode[pin] = mode;
+}
+inline void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin >= host::PIN_CNT) return;
+    host::state().pinOut[pin] = val ? HIGH : LOW;
+    if (!val) host::state().spiCs = pin;
+}
+inline int digitalRead(uint8_t pin) {
+    return (pin < host::PIN_CNT) ? host::state().pinIn[pin] : LOW;
+}
+inline int analogRead(uint8_t pin) {
+    host::State &s = host::state();
+    if (s.analogHook) return s.analogHook(pin);
+    return (pin < host::PIN_CNT) ? s.analog[pin] : 0;
+}
+
+/* ================= Print / Serial ================= */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual bool discards() const { return false; } // 出力先が無い場合は数値の整形を省く（リプレイ高速化）
+
+    size_t print(const char *s) { size_t n = 0; while (*s) n += write(static_cast<uint8_t>(*s++)); return n; }
+    size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char v, int base = 10) { return printNum(v, base); }
+    size_t print(int v, int base = 10) { return printSigned(v, base); }
+    size_t print(unsigned int v, int base = 10) { return printNum(v, base); }
+    size_t print(long v, int base = 10) { return printSigned(v, base); }
+    size_t print(unsigned long v, int base = 10) { return printNum(v, base); }
+    size_t print(long long v, int base = 10) { return printSigned(v, base); }
+    size_t print(unsigned long long v, int base = 10) { return printNum(v, base); }
+    size_t print(double v, int digits = 2) {
+        char buf[48];
+        if (discards()) return 0;
+        if (isnan(v)) return print("nan");
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        return print(buf);
+    }
+
+    size_t println() { return write('\r') + write('\n'); }
+    template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <class T> size_t println(T v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+
+private:
+    size_t printSigned(long long v, int base) {
+        if (v < 0 && base == 10) return write('-') + printNum(static_cast<unsigned long long>(-v), base);
+        return printNum(static_cast<unsigned long long>(v), base);
+    }
+    size_t printNum(unsigned long long v, int base) {
+        char buf[66]; int i = 0;
+        if (discards()) return 0;
+        if (base < 2) base = 10;
+        do { int d = static_cast<int>(v % base); buf[i++] = static_cast<char>(d < 10 ? '0' + d : 'A' + d - 10); v /= base; } while (v);
+        size_t n = 0; while (i) n += write(static_cast<uint8_t>(buf[--i]));
+        return n;
+    }
+};
+
+// 受信はテストから feed() で注入、送信は sink に流す（未設定なら破棄）
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    operator bool() const { return true; }
+    int available() const { return static_cast<int>(_rxLen - _rxPos); }
+    int read() { return (_rxPos < _rxLen) ? _rx[_rxPos++] : -1; }
+    int peek() const { return (_rxPos < _rxLen) ? _rx[_rxPos] : -1; }
+    int availableForWrite() const { return 64; }
+    void flush() {}
+    size_t write(uint8_t c) override { if (sink) sink(sinkCtx, c); return 1; }
+    bool discards() const override { return !sink; }
+    using Print::write;
+    size_t write(const uint8_t *b, size_t n) { for (size_t i = 0; i < n; i++) write(b[i]); return n; }
+
+    void feed(const uint8_t *b, size_t n) {
+        if (_rxPos == _rxLen) _rxPos = _rxLen = 0;
+        for (size_t i = 0; i < n && _rxLen < sizeof(_rx); i++) _rx[_rxLen++] = b[i];
+    }
+    void feed(const char *s) { feed(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+
+    void (*sink)(void *ctx, uint8_t c) = nullptr;
+    void *sinkCtx = nullptr;
+
+private:
+    uint8_t _rx[256];
+    size_t _rxPos = 0, _rxLen = 0;
+};
+
+static HardwareSerial Serial;
+static HardwareSerial Serial1;
@@ -0,0 +1,26 @@
+// ホストビルド用 EEPROM シム（host::state().eeprom を使用）
+#pragma once
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    uint8_t read(int addr) const { return host::state().eeprom[addr]; }
+    void write(int addr, uint8_t v) {
+        host::State &s = host::state();
+        s.eeprom[addr] = v; s.eepromWrites++;
+    }
+    void update(int addr, uint8_t v) { if (read(addr) != v) write(addr, v); }
+    uint16_t length() const { return host::EEPROM_SIZE; }
+
+    template <class T> T &get(int addr, T &t) const {
+        memcpy(&t, &host::state().eeprom[addr], sizeof(T)); return t;
+    }
+    // 実機のEEPROM.putはupdate()相当（変化したバイトのみ書き込む）
+    template <class T> const T &put(int addr, const T &t) {
+        const uint8_t *p = reinterpret_cast<const uint8_t *>(&t);
+        for (size_t i = 0; i < sizeof(T); i++) update(addr + static_cast<int>(i), p[i]);
+        return t;
+    }
+};
+
+static EEPROMClass EEPROM;
@@ -0,0 +1,21 @@
+// ホストビルド用 PID_ATune シム
+// ファームウェアはfloat領域をdouble*として渡すため（AVRではdouble==float）、
+// ここでは入出力ポインタを一切参照せず、一定回数の呼び出し後に完了を報告する。
+#pragma once
+#include <Arduino.h>
+
+class PID_ATune {
+public:
+    PID_ATune(double *, double *) {}
+    int Runtime() { return (++_calls >= DONE_AFTER) ? 1 : 0; }
+    void SetNoiseBand(double) {}
+    void SetOutputStep(double) {}
+    void SetLookbackSec(int) {}
+    void SetControlType(int) {}
+    double GetKp() { return 3.5; }
+    double GetKi() { return 0.05; }
+    double GetKd() { return 1.0; }
+    static const uint16_t DONE_AFTER = 120;
+private:
+    uint16_t _calls = 0;
+};
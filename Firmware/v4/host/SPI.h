@@ -0,0 +1,133 @@
+/*********************************************************************
+ * ホストビルド用 SPI シム + 熱電対アンプのモック
+ * ---------------------------------------------------------------
+ * CSでLOWにされたピンの熱電対アンプとして応答する。品種は
+ * host::state().tcChip（Config::Thermo::Chipと同じ番号）で選び、
+ * 温度は thermoC、故障は thermoFault（host::TcFault）から与える。
+ *
+ * [変換タイミング]
+ *   MAX6675 (220ms) / MAX31855 (100ms): CSを上げると変換開始。
+ *     変換完了前にCSを下げると変換は中断され、前回の結果を返す
+ *   MAX31856 (100ms): CR0のCMODEで連続変換。CSとは無関係に更新され、
+ *     設定前（電源投入直後）は変換しない
+ *********************************************************************/
+#pragma once
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+namespace host {
+    // 熱電対の故障注入（NaNの温度は断線として扱う）
+    enum TcFault : uint8_t { TC_OK, TC_OPEN, TC_SHORT_GND, TC_SHORT_VCC, TC_CJ_RANGE, TC_BUS };
+
+    constexpr uint16_t TC_CONV_MS[] = { 220, 100, 100 }; // 品種ごとの最大変換時間
+
+    // 変換結果をレジスタに格納（MAX6675/MAX31855は読み出しフレーム、MAX31856はLTCB/SR）
+    static void tcLatch(uint8_t cs) {
+        State &s = state();
+        uint8_t *r = s.tcReg[cs];
+        uint8_t f = isnan(s.thermoC[cs]) ? static_cast<uint8_t>(TC_OPEN) : s.thermoFault[cs];
+        float c = s.thermoC[cs];
+        constexpr float CJ_C = 25.0f; // 基板（冷接点）温度
+        if (f == TC_SHORT_GND) { c = CJ_C; } // 熱起電力が消え、冷接点温度を示す
+        switch (s.tcChip) {
+        case 0: { // MAX6675: D14..D3 温度(0.25℃), D2 断線
+            uint16_t v;
+            if (f == TC_BUS) v = 0xFFFF;
+            else if (f == TC_OPEN) v = 0x0004;
+            else if (f == TC_SHORT_VCC) v = 0x7FF8; // 断線検出は効かず上限に張り付く
+            else v = static_cast<uint16_t>(constrain(floorf(c * 4.0f), 0.0f, 4095.0f)) << 3;
+            r[0] = v >> 8; r[1] = v & 0xFF;
+            break;
+        }
+        case 1: { // MAX31855: D31..D18 温度(0.25℃), D16 異常, D15..D4 冷接点(0.0625℃), D2 SCV, D1 SCG, D0 OC
+            uint32_t v;
+            if (f == TC_BUS) v = 0xFFFFFFFFUL;
+            else {
+                v = static_cast<uint32_t>(static_cast<int32_t>(CJ_C * 16.0f) & 0xFFF) << 4;
+                if (f == TC_OPEN) v |= 0x10001UL;
+                else if (f == TC_SHORT_GND) v |= 0x10002UL;
+                else if (f == TC_SHORT_VCC) v |= 0x10004UL;
+                else v |= static_cast<uint32_t>(static_cast<int32_t>(constrain(floorf(c * 4.0f), -1080.0f, 7200.0f)) & 0x3FFF) << 18;
+            }
+            r[0] = v >> 24; r[1] = (v >> 16) & 0xFF; r[2] = (v >> 8) & 0xFF; r[3] = v & 0xFF;
+            break;
+        }
+        default: { // MAX31856: 0x0C..0x0E 温度(1/128℃、19bit), 0x0F SR
+            uint8_t sr = 0;
+            if (f == TC_OPEN && (r[0] & 0x30)) sr = 0x01; // 断線検出はOCFAULT設定時のみ
+            else if (f == TC_SHORT_GND || f == TC_SHORT_VCC) sr = 0x02;
+            else if (f == TC_CJ_RANGE) sr = 0x80;
+            if (f != TC_OPEN) {
+                int32_t t = static_cast<int32_t>(constrain(floorf(c * 128.0f), -270.0f * 128, 1372.0f * 128));
+                uint32_t v = static_cast<uint32_t>(t) << 5;
+                r[0x0C] = (v >> 16) & 0xFF; r[0x0D] = (v >> 8) & 0xFF; r[0x0E] = v & 0xFF;
+            }
+            r[0x0F] = sr;
+            break;
+        }
+        }
+    }
+}
+
+class SPISettings {
+public:
+    SPISettings(uint32_t clock = 4000000UL, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+    uint32_t clock; uint8_t bitOrder, dataMode;
+};
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(const SPISettings &) {}
+
+    // CSが上がっていればフレーム終了（MAX6675/MAX31855はここから次の変換）
+    void endTransaction() {
+        host::State &s = host::state();
+        if (!_inFrame || s.pinOut[_cs] == LOW) return;
+        _inFrame = false;
+        if (s.tcChip < 2) s.tcConvMs[_cs] = s.ms;
+    }
+
+    uint8_t transfer(uint8_t out) {
+        host::State &s = host::state();
+        uint8_t cs = s.spiCs;
+        if (s.pinOut[cs] != LOW) return 0xFF; // 誰も選択されていない（プルアップ）
+        if (s.thermoFault[cs] == host::TC_BUS) return 0xFF;
+        uint8_t *r = s.tcReg[cs];
+        uint32_t conv = host::TC_CONV_MS[s.tcChip < 2 ? s.tcChip : 2];
+        if (!_inFrame || _cs != cs) {
+            _inFrame = true; _cs = cs; _pos = 0;
+            if (s.tcChip < 2) {
+                if (s.ms - s.tcConvMs[cs] >= conv) host::tcLatch(cs); // 未完了なら中断して前回値
+            } else if (r[0] & 0x80) {
+                uint32_t n = (s.ms - s.tcConvMs[cs]) / conv;
+                if (n) { s.tcConvMs[cs] += n * conv; host::tcLatch(cs); }
+            } else {
+                s.tcConvMs[cs] = s.ms; // 停止中（設定すると次の周期から変換）
+            }
+        }
+        if (s.tcChip < 2) return (_pos < 4) ? r[_pos++] : 0;
+
+        // MAX31856: 最初のバイトがアドレス（bit7で書き込み）、以降は自動インクリメント
+        if (_pos++ == 0) { _addr = out; return 0xFF; }
+        uint8_t a = _addr & 0x0F;
+        _addr = (_addr & 0x80) | ((a + 1) & 0x0F);
+        if (!(_addr & 0x80)) return r[a];
+        if (a < 0x0C) r[a] = out; // 変換結果とSRは読み出し専用
+        return 0xFF;
+    }
+
+private:
+    bool _inFrame = false;
+    uint8_t _cs = 0, _pos = 0, _addr = 0;
+};
+
+static SPIClass SPI;
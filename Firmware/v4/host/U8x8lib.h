@@ -0,0 +1,37 @@
+// ホストビルド用 U8x8 シム
+// 16x8文字のテキスト画面とタイル送信数を記録する（I2C転送量の見積もり用）
+#pragma once
+#include <Arduino.h>
+
+#define U8X8_PIN_NONE 255
+
+static const uint8_t u8x8_font_chroma48medium8_r[1] = {1};
+static const uint8_t u8x8_font_px437wyse700b_2x2_r[1] = {2};
+
+class U8X8_SH1106_128X64_NONAME_HW_I2C : public Print {
+public:
+    explicit U8X8_SH1106_128X64_NONAME_HW_I2C(uint8_t) { clear(); }
+    bool begin() { clear(); return true; }
+    void clear() { memset(text, ' ', sizeof(text)); memset(tiles, 0, sizeof(tiles)); _x = _y = 0; tilesSent += 128; }
+    void clearLine(uint8_t line) { if (line < 8) memset(text[line], ' ', 16); tilesSent += 16; }
+    void setFont(const uint8_t *f) { _scale = (f == u8x8_font_px437wyse700b_2x2_r) ? 2 : 1; }
+    void setCursor(uint8_t x, uint8_t y) { _x = x; _y = y; }
+    void setInverseFont(uint8_t) {}
+    void drawTile(uint8_t x, uint8_t y, uint8_t cnt, const uint8_t *t) {
+        for (uint8_t i = 0; i < cnt && x + i < 16 && y < 8; i++) memcpy(tiles[y][x + i], t + 8 * i, 8);
+        tilesSent += cnt;
+    }
+    size_t write(uint8_t c) override {
+        if (_y < 8 && _x < 16) text[_y][_x] = static_cast<char>(c);
+        tilesSent += _scale * _scale;
+        _x += _scale;
+        return 1;
+    }
+    using Print::write;
+
+    char text[8][16];
+    uint8_t tiles[8][16][8];
+    uint32_t tilesSent = 0;
+private:
+    uint8_t _x = 0, _y = 0, _scale = 1;
+};
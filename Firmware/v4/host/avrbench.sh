@@ -0,0 +1,36 @@
+#!/bin/sh
+# El-Pico v4 ターゲット実測ベンチ（avr-gcc + simavr）
+# 計測用フラグ（-DEL_PICO_CYCLES）付きでファームウェアをビルドし、avrcycles で実行して
+# cycle_budget.txt と比べる。予算超過で終了コード1
+# ビルド直後に avr-size -A の .text/.data/.bss/.noinit を表示する（RAM予算はこのうち .data + .bss + .noinit）
+#
+# 必要: arduino-cli（arduino:avr コア、U8g2・PID_AutoTune ライブラリ）、simavr（libsimavr）、libelf
+# 環境変数: FQBN（既定 arduino:avr:leonardo = Pro Micro と同じ ATmega32U4/Caterina）、OUT（作業ディレクトリ）、
+#           AVR_SIZE（既定は PATH の avr-size、無ければ arduino-cli が入れた avr-gcc のもの）
+#
+# 例:
+#   Firmware/v4/host/avrbench.sh
+#   Firmware/v4/host/avrbench.sh --seconds 120 --only tick
+#   Firmware/v4/host/avrbench.sh --suggest > /tmp/measured.txt   # 実測から予算の案を作る
+set -e
+HOST=$(cd "$(dirname "$0")" && pwd)
+FQBN=${FQBN:-arduino:avr:leonardo}
+OUT=${OUT:-${TMPDIR:-/tmp}/el_pico_avrbench}
+
+# arduino-cli はスケッチのフォルダ名と同名の .ino を要求する（main.cpp はそのままコンパイルされる）
+mkdir -p "$OUT/el_pico"
+cp "$HOST/../main.cpp" "$OUT/el_pico/main.cpp"
+: > "$OUT/el_pico/el_pico.ino"
+arduino-cli compile -b "$FQBN" --build-property "compiler.cpp.extra_flags=-DEL_PICO_CYCLES" \
+    --output-dir "$OUT/build" "$OUT/el_pico" > "$OUT/compile.log"
+ELF="$OUT/build/el_pico.ino.elf"
+
+AVR_SIZE=${AVR_SIZE:-$(command -v avr-size || ls "$HOME"/.arduino15/packages/arduino/tools/avr-gcc/*/bin/avr-size 2>/dev/null | tail -n 1)}
+if [ -n "$AVR_SIZE" ]; then
+    "$AVR_SIZE" -A "$ELF" | grep -E '^\.(text|data|bss|noinit) ' >&2
+else
+    echo "avr-size not found (set AVR_SIZE)" >&2
+fi
+
+c++ -std=c++17 -O2 -o "$OUT/avrcycles" "$HOST/avrcycles.cpp" $(pkg-config --cflags --libs simavr) -lelf
+exec "$OUT/avrcycles" --budget "$HOST/cycle_budget.txt" "$@" "$ELF"
@@ -0,0 +1,295 @@
+/*********************************************************************
+ * El-Pico v4 ターゲット実測ベンチ（simavr 上で実行）
+ * ---------------------------------------------------------------
+ * -DEL_PICO_CYCLES でビルドしたファームウェア（ATmega32U4, 16MHz）をsimavrで
+ * 実行し、CYCLE PROBE 区間（loop / tick / calculatePower / renderOLED /
+ * debugTelemetry）のサイクル数と、ELFのFlash・RAM使用量をJSON Lines で出力する。
+ * --budget に渡した上限を超えた項目を報告し、終了コード1を返す。
+ *
+ * [計測] GPIOR1（区間の入口）/GPIOR2（出口）への書き込みを捕まえ、その間の
+ *   サイクル数を数える。割り込み（millisのTimer0、USB）の処理時間も含む実時間
+ * [周辺のスタブ]
+ *   熱電対  CS（A0〜A3 = PF7〜PF4）の立ち下がりでフレームを始め、MAX6675の
+ *           読み出しフレームを返す（温度は下の簡易プラントから）
+ *   SSR     D5(PC6)/D6(PD7)の出力から、ゾーンごとの一次遅れのプレート/素線温度を進める
+ *   OLED    I2Cのアドレスとデータを常にACKする（内容は捨てる）
+ *   USB     PLLのロックを即座に返す（ホスト未接続のCDCとして動く）
+ *   入力    エンコーダとスイッチは離した状態（IDLEから自動で予熱に入る）
+ *
+ * ビルド: g++ -std=c++17 -O2 -o avrcycles Firmware/v4/host/avrcycles.cpp $(pkg-config --cflags --libs simavr) -lelf
+ *         （ファームウェアのビルドから実行までは avrbench.sh）
+ *
+ * 予算: cycle_budget.txt（「項目 上限」の行。項目は <区間>.max / <区間>.avg / flash / ram）
+ *       --suggest で、今回の実測（最悪値・平均の1.5倍）から同じ形式の予算を出力する
+ *
+ * 例:
+ *   ./avrcycles --budget Firmware/v4/host/cycle_budget.txt el_pico.ino.elf
+ *   ./avrcycles --seconds 120 --only tick el_pico.ino.elf
+ *********************************************************************/
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <gelf.h>
+#include <unistd.h>
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_io.h>
+#include <avr_ioport.h>
+#include <avr_spi.h>
+#include <avr_twi.h>
+
+namespace {
+
+/* ================= PROBES ================= */
+// main.cpp の CycleProbe::Id と同じ順（0は未使用）
+const char *const NAMES[] = { "", "loop", "tick", "power", "oled", "telem" };
+constexpr uint8_t PROBE_CNT = sizeof(NAMES) / sizeof(NAMES[0]);
+
+constexpr avr_io_addr_t GPIOR1_ADDR = 0x4A, GPIOR2_ADDR = 0x4B; // データ空間のアドレス（I/O 0x2A/0x2B）
+constexpr avr_io_addr_t PLLCSR_ADDR = 0x49;
+constexpr uint8_t PLOCK = 0x01;
+constexpr uint32_t F_CPU_HZ = 16000000UL;
+
+struct Probe {
+    uint64_t startCyc = 0, calls = 0, total = 0, minCyc = UINT64_MAX, maxCyc = 0;
+    bool open = false;
+};
+Probe probes[PROBE_CNT];
+
+void onEnter(avr_t *avr, avr_io_addr_t, uint8_t v, void *) {
+    if (v >= PROBE_CNT) return;
+    probes[v].startCyc = avr->cycle;
+    probes[v].open = true;
+}
+
+void onExit(avr_t *avr, avr_io_addr_t, uint8_t v, void *) {
+    if (v >= PROBE_CNT || !probes[v].open) return;
+    Probe &p = probes[v];
+    uint64_t c = avr->cycle - p.startCyc;
+    p.open = false;
+    p.calls++; p.total += c;
+    if (c < p.minCyc) p.minCyc = c;
+    if (c > p.maxCyc) p.maxCyc = c;
+}
+
+/* ================= PERIPHERAL STUBS ================= */
+// ゾーンごとの簡易プラント（ホストのsim.hより粗い。区間の分岐を実運転に近づけるためだけに使う）
+struct Zone {
+    bool ssr = false;
+    float duty = 0.0f;                  // SSRの時間比率（時定数20秒で平滑）
+    float plateC = 25.0f, heaterC = 25.0f;
+    void step(float dt) {
+        duty += ((ssr ? 1.0f : 0.0f) - duty) * dt / 20.0f;
+        plateC += (0.6f * (ssr ? 1.0f : 0.0f) - 0.001f * (plateC - 25.0f)) * dt;
+        heaterC = plateC + 250.0f * duty;
+    }
+};
+Zone zones[2]; // 0: 上火, 1: 下火
+
+// CSピン（ポートFのビット）→ ゾーンと素線/プレート
+struct CsPin { uint8_t bit, zone; bool heater; };
+const CsPin CS_PINS[] = { { 7, 0, true }, { 6, 0, false }, { 5, 1, true }, { 4, 1, false } }; // A0〜A3
+
+struct Spi {
+    avr_irq_t *in = nullptr;
+    uint8_t frame[2] = { 0, 0 }, pos = 2;
+} spi;
+
+void onCs(avr_irq_t *, uint32_t level, void *param) {
+    if (level) return;
+    const CsPin &cs = *static_cast<const CsPin *>(param);
+    const Zone &z = zones[cs.zone];
+    float c = cs.heater ? z.heaterC : z.plateC;
+    uint16_t v = static_cast<uint16_t>(fminf(fmaxf(c * 4.0f, 0.0f), 4095.0f)) << 3; // MAX6675: D14..D3
+    spi.frame[0] = v >> 8; spi.frame[1] = v & 0xFF;
+    spi.pos = 0;
+}
+
+// 送信完了ごとに次の受信バイトを返す（CSの外では 0xFF）
+void onSpiOut(avr_irq_t *, uint32_t, void *) {
+    avr_raise_irq(spi.in, spi.pos < 2 ? spi.frame[spi.pos++] : 0xFF);
+}
+
+void onSsr(avr_irq_t *, uint32_t level, void *param) {
+    static_cast<Zone *>(param)->ssr = level != 0;
+}
+
+avr_irq_t *twiIn = nullptr;
+void onTwiOut(avr_irq_t *, uint32_t value, void *) {
+    avr_twi_msg_irq_t m;
+    m.u.v = value;
+    if (m.u.twi.msg & (TWI_COND_START | TWI_COND_WRITE)) avr_raise_irq(twiIn, avr_twi_irq_msg(TWI_COND_ACK, m.u.twi.addr, 1));
+}
+
+void onPllcsr(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *) {
+    avr->data[addr] = (v & 0x02) ? static_cast<uint8_t>(v | PLOCK) : static_cast<uint8_t>(v & ~PLOCK); // PLLE でロック
+}
+
+void attach(avr_t *avr) {
+    avr_register_io_write(avr, GPIOR1_ADDR, onEnter, nullptr);
+    avr_register_io_write(avr, GPIOR2_ADDR, onExit, nullptr);
+    avr_register_io_write(avr, PLLCSR_ADDR, onPllcsr, nullptr);
+
+    for (const CsPin &cs : CS_PINS)
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('F'), cs.bit), onCs, const_cast<CsPin *>(&cs));
+    spi.in = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), onSpiOut, nullptr);
+
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), 6), onSsr, &zones[0]); // D5
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 7), onSsr, &zones[1]); // D6
+
+    twiIn = avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), onTwiOut, nullptr);
+
+    // エンコーダ CLK=D7(PE6), DT=D8(PB4), SW=D4(PD4) は離した状態（プルアップ）
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('E'), 6), 1);
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 4), 1);
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 4), 1);
+}
+
+/* ================= SIZE ================= */
+// セクションの大きさ（バイト）。見つからなければ0、ELFを読めなければ-1
+// simavrのローダーは .noinit（WarmState）を読まないため、セクションヘッダーから直接数える
+long sectionSize(const char *path, const char *name) {
+    if (elf_version(EV_CURRENT) == EV_NONE) return -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    long size = -1;
+    Elf *e = elf_begin(fd, ELF_C_READ, nullptr);
+    size_t shstr;
+    if (e && elf_getshdrstrndx(e, &shstr) == 0) {
+        size = 0;
+        for (Elf_Scn *s = elf_nextscn(e, nullptr); s; s = elf_nextscn(e, s)) {
+            GElf_Shdr sh;
+            if (!gelf_getshdr(s, &sh)) continue;
+            const char *n = elf_strptr(e, shstr, sh.sh_name);
+            if (n && !strcmp(n, name)) { size = static_cast<long>(sh.sh_size); break; }
+        }
+    }
+    if (e) elf_end(e);
+    close(fd);
+    return size;
+}
+
+/* ================= BUDGET ================= */
+// 「項目 上限」の行を読み、項目ごとに実測値と比べる（#以降はコメント）
+int checkBudget(const char *path, const double *flashRam) {
+    FILE *f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "cannot open %s\n", path); return 1; }
+    int over = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        char key[32];
+        double limit;
+        if (sscanf(line, "%31s %lf", key, &limit) != 2) continue;
+        double v = NAN;
+        if (!strcmp(key, "flash")) v = flashRam[0];
+        else if (!strcmp(key, "ram")) v = flashRam[1];
+        else {
+            char *dot = strchr(key, '.');
+            if (!dot) { fprintf(stderr, "unknown budget %s\n", key); over++; continue; }
+            *dot = 0;
+            for (uint8_t i = 1; i < PROBE_CNT; i++) {
+                if (strcmp(key, NAMES[i]) || !probes[i].calls) continue;
+                if (!strcmp(dot + 1, "max")) v = static_cast<double>(probes[i].maxCyc);
+                else if (!strcmp(dot + 1, "avg")) v = static_cast<double>(probes[i].total) / probes[i].calls;
+            }
+            *dot = '.';
+        }
+        if (std::isnan(v)) { fprintf(stderr, "NOT MEASURED %s\n", key); over++; continue; }
+        if (v > limit) { fprintf(stderr, "OVER BUDGET %s: %.0f > %.0f\n", key, v, limit); over++; }
+    }
+    fclose(f);
+    return over;
+}
+
+// 実測から予算を出力する（サイクルは1.5倍を1000単位で切り上げ。Flash/RAMは容量で決まるので出さない）
+void suggestBudget() {
+    for (uint8_t i = 1; i < PROBE_CNT; i++) {
+        const Probe &p = probes[i];
+        if (!p.calls) continue;
+        printf("%s.max\t%.0f\n", NAMES[i], std::ceil(p.maxCyc * 1.5 / 1000.0) * 1000.0);
+        if (i == 1) printf("%s.avg\t%.0f\n", NAMES[i], std::ceil(static_cast<double>(p.total) / p.calls * 1.5 / 1000.0) * 1000.0);
+    }
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: avrcycles [options] firmware.elf\n"
+        "  --seconds S     simulated run time (default 40)\n"
+        "  --mcu NAME      simavr core (default atmega32u4)\n"
+        "  --budget FILE   fail when a measured value exceeds its budget\n"
+        "  --only NAME     print only this probe (loop, tick, power, oled, telem, size)\n"
+        "  --suggest       print a budget file (1.5x the measured cycles) instead of JSON\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *elf = nullptr, *budget = nullptr, *only = nullptr, *mcu = "atmega32u4";
+    double seconds = 40.0;
+    bool suggest = false;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (a[0] != '-') { elf = a; continue; }
+        if (!strcmp(a, "--suggest")) { suggest = true; continue; }
+        const char *v = (i + 1 < argc) ? argv[++i] : nullptr;
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--seconds")) seconds = atof(v);
+        else if (!strcmp(a, "--mcu")) mcu = v;
+        else if (!strcmp(a, "--budget")) budget = v;
+        else if (!strcmp(a, "--only")) only = v;
+        else { usage(); return 2; }
+    }
+    if (!elf || seconds <= 0.0) { usage(); return 2; }
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elf, &fw) != 0) { fprintf(stderr, "cannot read %s\n", elf); return 2; }
+    avr_t *avr = avr_make_mcu_by_name(mcu);
+    if (!avr) { fprintf(stderr, "simavr has no core for %s\n", mcu); return 2; }
+    avr_init(avr);
+    avr->frequency = F_CPU_HZ;
+    avr_load_firmware(avr, &fw);
+    attach(avr);
+
+    // プラントは1msごとに進める
+    const uint64_t end = static_cast<uint64_t>(seconds * F_CPU_HZ), stepCyc = F_CPU_HZ / 1000;
+    uint64_t nextStep = stepCyc;
+    int state = cpu_Running;
+    while (avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+        state = avr_run(avr);
+        while (avr->cycle >= nextStep) {
+            for (Zone &z : zones) z.step(0.001f);
+            nextStep += stepCyc;
+        }
+    }
+    if (state == cpu_Crashed) { fprintf(stderr, "firmware crashed at %.3f s\n", avr->cycle / static_cast<double>(F_CPU_HZ)); return 1; }
+
+    if (suggest) { suggestBudget(); return 0; }
+
+    for (uint8_t i = 1; i < PROBE_CNT; i++) {
+        const Probe &p = probes[i];
+        if (only && strcmp(only, NAMES[i])) continue;
+        if (!p.calls) { printf("{\"probe\":\"%s\",\"calls\":0}\n", NAMES[i]); continue; }
+        printf("{\"probe\":\"%s\",\"calls\":%llu,\"min\":%llu,\"avg\":%.0f,\"max\":%llu,\"max_us\":%.1f}\n",
+               NAMES[i], static_cast<unsigned long long>(p.calls), static_cast<unsigned long long>(p.minCyc),
+               static_cast<double>(p.total) / p.calls, static_cast<unsigned long long>(p.maxCyc), p.maxCyc * 1e6 / F_CPU_HZ);
+    }
+    // Flash = .text + .data の初期値（simavrのローダーが連結済み）、RAM = .data + .bss + .noinit（スタックとヒープはMemProbeで実測）
+    const long noinit = sectionSize(elf, ".noinit");
+    if (noinit < 0) { fprintf(stderr, "cannot read section headers of %s\n", elf); return 2; }
+    double flashRam[2] = { static_cast<double>(fw.flashsize), static_cast<double>(fw.datasize + fw.bsssize + noinit) };
+    if (!only || !strcmp(only, "size"))
+        printf("{\"probe\":\"size\",\"flash\":%.0f,\"data\":%u,\"bss\":%u,\"noinit\":%ld,\"ram\":%.0f}\n",
+               flashRam[0], fw.datasize, fw.bsssize, noinit, flashRam[1]);
+
+    return (budget && checkBudget(budget, flashRam)) ? 1 : 0;
+}
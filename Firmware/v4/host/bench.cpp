@@ -0,0 +1,327 @@
+/*********************************************************************
+ * El-Pico v4 制御品質ベンチマーク（ホスト用）
+ * ---------------------------------------------------------------
+ * 固定シナリオ（乱数シード固定）をシミュレーター上で実行し、制御品質のKPIを
+ * JSON Lines（1シナリオ1行）で出力する。保存した結果を --baseline に渡すと
+ * 悪化した項目を報告し、終了コード1を返す（リリース前の回帰チェック用）。
+ *
+ * [シナリオ]
+ *   cold     冷間起動からREADYまで、その後10分間の整定
+ *   switch   READY中にNapoli→Romanaへ切替（目標温度の降下）
+ *   rush     READYになり次第ピザを投入し続ける10枚連続焼成
+ *   noise    熱電対の欠損バースト・ノイズ増加下での予熱と焼成
+ *   lowpower 0.7kW制限でのRomanaの予熱と焼成
+ *   planmiss 劣化した素線（出力70%）で間に合わないRomanaの予約予熱（ready 60）。予約時刻で通常の
+ *            予熱に切り替わった後、無人のままREADYに届くこと（ready_s は予約からの時間）
+ *   planlong 1.0kW制限でのNapoliの5時間先の予約予熱（開始を遅らせて予約時刻に合わせること）
+ *
+ * [KPI] 値が小さいほど良い（未計測はnull）
+ *   ready_s       READYまでの時間（switchは切替から）
+ *   overshoot_c   最初のREADY以降の表面温度の目標超過の最大値（cold/switch は固定の上限あり）
+ *   settle_s      目標±READY幅に入ったまま留まるまでの時間（観測窓の終わりまで）
+ *   recover_s     取り出しからREADY復帰までの平均（recover_max_s は最大）
+ *   wh_per_pizza  1枚あたりの電力量
+ *   peak_heater_c ヒーター素線の最高温度
+ *   errors        ERRORへの遷移回数 / rejects 棄却した熱電対サンプル数
+ *   deadline_s    予約予熱でREADYになった時刻と予約時刻の差（早すぎても遅すぎても悪い。planlong は固定の上限あり）
+ *
+ * ビルド: g++ -std=c++17 -O2 -I Firmware/v4/host -o bench Firmware/v4/host/bench.cpp
+ *
+ * 基準値: bench_baseline.jsonl（制御の挙動を意図して変えた場合は同じコマンドで更新する）
+ *
+ * 例:
+ *   ./bench --baseline Firmware/v4/host/bench_baseline.jsonl
+ *   ./bench > Firmware/v4/host/bench_baseline.jsonl
+ *********************************************************************/
+#include <string>
+
+#include "sim.h"
+
+namespace {
+
+/* ================= KPI ================= */
+enum Metric : uint8_t {
+    READY_S, OVERSHOOT_C, SETTLE_S, RECOVER_S, RECOVER_MAX_S, WH_PER_PIZZA, PEAK_HEATER_C, ERRORS, REJECTS, DEADLINE_S, METRIC_CNT
+};
+const char *const METRIC_NAMES[METRIC_CNT] = {
+    "ready_s", "overshoot_c", "settle_s", "recover_s", "recover_max_s", "wh_per_pizza", "peak_heater_c", "errors", "rejects",
+    "deadline_s"
+};
+// 比較時の最小許容差（割合の許容値だけでは小さな値のゆらぎを拾うため）
+const float METRIC_SLACK[METRIC_CNT] = { 5.0f, 1.0f, 5.0f, 5.0f, 5.0f, 1.0f, 2.0f, 0.0f, 5.0f, 60.0f };
+
+struct Result {
+    float m[METRIC_CNT];
+    uint16_t pizzas;
+    bool ok;
+};
+
+/* ================= OBSERVER ================= */
+// 目標温度帯からの逸脱を1秒ごとに記録し、整定時間を求める
+struct Settle {
+    uint32_t t0 = 0, lastOutMs = 0;
+    bool active = false;
+
+    void start() { t0 = lastOutMs = millis(); active = true; }
+    void sample(const sim::Plant &p) {
+        if (!active) return;
+        float upT, loT;
+        zoneTargets(upT, loT);
+        if (f_abs(p.up.surfC - upT) >= settings.readyBandC || f_abs(p.lo.surfC - loT) >= settings.readyBandC) lastOutMs = millis();
+    }
+    float seconds() const { return (lastOutMs - t0) / 1000.0f; }
+};
+
+struct Bench {
+    sim::Runner r;
+    Settle settle;
+    uint16_t errors = 0;
+    OvenState last = OvenState::IDLE;
+
+    explicit Bench(uint8_t recipe = 0, uint8_t limit = 0, uint32_t seed = 1) {
+        r.everySecond = [this] {
+            settle.sample(r.plant);
+            if (oven == OvenState::ERROR && last != OvenState::ERROR) errors++;
+            last = oven;
+        };
+        Settings st = defaultSettings();
+        st.recipeIdx = recipe; st.limitIdx = limit;
+        r.attended = true; // 観測中にエコ保温へ落ちないよう操作者が常駐している想定
+        r.boot(&st, seed);
+    }
+
+    Result result() const {
+        Result res;
+        for (float &v : res.m) v = NAN;
+        res.m[OVERSHOOT_C] = r.kpi.overshootC;
+        res.m[PEAK_HEATER_C] = r.kpi.peakHeaterC;
+        res.m[ERRORS] = errors;
+        res.m[REJECTS] = up.rejects + lo.rejects;
+        res.pizzas = 0;
+        res.ok = true;
+        return res;
+    }
+
+    void service(Result &res, uint16_t n, uint32_t intervalMs) {
+        sim::ServiceResult s = sim::runService(r, n, intervalMs);
+        res.ok = s.ok;
+        res.pizzas = s.baked;
+        res.m[READY_S] = s.readyS;
+        res.m[RECOVER_S] = s.recoverS;
+        res.m[RECOVER_MAX_S] = s.recoverMaxS;
+        res.m[WH_PER_PIZZA] = s.whPerPizza;
+    }
+};
+
+constexpr uint32_t SETTLE_WINDOW_MS = 10UL * 60UL * 1000UL;
+constexpr uint32_t READY_TIMEOUT_MS = 2UL * 3600UL * 1000UL;
+
+Result cold() {
+    Bench b;
+    uint32_t t0 = millis();
+    bool ok = sim::waitReady(b.r, READY_TIMEOUT_MS);
+    float readyS = (millis() - t0) / 1000.0f;
+    // 予熱開始から数えた整定時間（READY時点の逸脱は観測窓内で上書きされる）
+    b.settle.start(); b.settle.t0 = t0;
+    b.r.run(SETTLE_WINDOW_MS);
+    Result res = b.result();
+    res.ok = ok;
+    res.m[READY_S] = readyS;
+    res.m[SETTLE_S] = b.settle.seconds();
+    return res;
+}
+
+Result recipeSwitch() {
+    Bench b(0);
+    bool ok = sim::waitReady(b.r, READY_TIMEOUT_MS);
+    b.r.run(60000);
+    uint32_t t0 = millis();
+    b.r.selectRecipe(1);
+    b.r.runUntil([] { return oven != OvenState::READY; }, 5000UL); // 次の制御周期で切替が反映される
+    b.r.kpi.overshootC = 0; b.r.kpi.armed = false; // 切替後、再びREADYになってからの超過量のみを見る
+    b.settle.start(); b.settle.t0 = t0;
+    ok = ok && sim::waitReady(b.r, READY_TIMEOUT_MS);
+    float readyS = (millis() - t0) / 1000.0f;
+    b.r.run(SETTLE_WINDOW_MS);
+    Result res = b.result();
+    res.ok = ok;
+    res.m[READY_S] = readyS;
+    res.m[SETTLE_S] = b.settle.seconds();
+    return res;
+}
+
+Result rush() {
+    Bench b;
+    Result res = b.result();
+    b.service(res, 10, 0);
+    Result k = b.result();
+    res.m[OVERSHOOT_C] = k.m[OVERSHOOT_C]; res.m[PEAK_HEATER_C] = k.m[PEAK_HEATER_C];
+    res.m[ERRORS] = k.m[ERRORS]; res.m[REJECTS] = k.m[REJECTS];
+    return res;
+}
+
+Result noise() {
+    Bench b(0, 0, 7);
+    b.r.plant.noiseC = 1.5f;
+    // 2分ごとに10秒間、読み取りの15%が欠損するバースト
+    auto prev = b.r.everySecond;
+    b.r.everySecond = [&b, prev] {
+        prev();
+        b.r.plant.nanProb = ((millis() / 1000UL) % 120UL < 10UL) ? 0.15f : 0.0f;
+    };
+    Result res = b.result();
+    b.service(res, 5, 180000UL);
+    Result k = b.result();
+    res.m[OVERSHOOT_C] = k.m[OVERSHOOT_C]; res.m[PEAK_HEATER_C] = k.m[PEAK_HEATER_C];
+    res.m[ERRORS] = k.m[ERRORS]; res.m[REJECTS] = k.m[REJECTS];
+    return res;
+}
+
+Result lowPower() {
+    Bench b(1, 2); // 0.7kWで届くRomana
+    Result res = b.result();
+    b.service(res, 3, 300000UL);
+    Result k = b.result();
+    res.m[OVERSHOOT_C] = k.m[OVERSHOOT_C]; res.m[PEAK_HEATER_C] = k.m[PEAK_HEATER_C];
+    res.m[ERRORS] = k.m[ERRORS]; res.m[REJECTS] = k.m[REJECTS];
+    return res;
+}
+
+Result planMiss() {
+    Bench b(1);
+    b.r.attended = false; // 予約した後は誰もいない
+    b.r.plant.up.drift = b.r.plant.lo.drift = 0.7f;
+    uint32_t t0 = millis();
+    Serial.feed("ready 60\n");
+    // エコ保温・休止に落ちたら失敗（waitReady のように再加熱のボタンは押さない）
+    bool ok = b.r.runUntil([] {
+        return oven == OvenState::READY || oven == OvenState::ECO || oven == OvenState::REST;
+    }, 4UL * 3600UL * 1000UL) && oven == OvenState::READY;
+    Result res = b.result();
+    res.ok = ok;
+    res.m[READY_S] = (millis() - t0) / 1000.0f;
+    return res;
+}
+
+Result planLong() {
+    Bench b(0, 1);
+    uint32_t t0 = millis();
+    Serial.feed("ready 300\n");
+    bool ok = sim::waitReady(b.r, 6UL * 3600UL * 1000UL);
+    Result res = b.result();
+    res.ok = ok;
+    res.m[READY_S] = (millis() - t0) / 1000.0f;
+    res.m[DEADLINE_S] = f_abs(res.m[READY_S] - 300.0f * 60.0f);
+    return res;
+}
+
+// overshootMaxC: 基準値の更新に関わらず超えてはならない行き過ぎ（目標軌道の導入前のcoldの値。NANは対象外）
+// deadlineMaxS: 同じく、予約時刻からのずれの上限（NANは対象外）
+struct Scenario { const char *name; Result (*fn)(); float overshootMaxC, deadlineMaxS; };
+const Scenario scenarios[] = {
+    { "cold", cold, 0.44f, NAN }, { "switch", recipeSwitch, 0.44f, NAN }, { "rush", rush, NAN, NAN },
+    { "noise", noise, NAN, NAN }, { "lowpower", lowPower, NAN, NAN }, { "planmiss", planMiss, NAN, NAN },
+    { "planlong", planLong, NAN, 120.0f },
+};
+constexpr size_t SCENARIO_CNT = sizeof(scenarios) / sizeof(scenarios[0]);
+
+/* ================= OUTPUT / BASELINE ================= */
+std::string toJson(const char *name, const Result &r) {
+    char buf[64];
+    std::string s = "{\"scenario\":\"";
+    s += name;
+    s += "\",\"ok\":";
+    s += r.ok ? "true" : "false";
+    snprintf(buf, sizeof(buf), ",\"pizzas\":%u", r.pizzas);
+    s += buf;
+    for (uint8_t m = 0; m < METRIC_CNT; m++) {
+        if (isnan(r.m[m])) snprintf(buf, sizeof(buf), ",\"%s\":null", METRIC_NAMES[m]);
+        else snprintf(buf, sizeof(buf), ",\"%s\":%.2f", METRIC_NAMES[m], r.m[m]);
+        s += buf;
+    }
+    return s + "}";
+}
+
+// 自身が出力した形式のJSON Linesを読む（"key":number の組のみ）
+bool readBaseline(const char *path, const char *name, Result &out) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[1024];
+    std::string tag = std::string("\"scenario\":\"") + name + "\"";
+    bool found = false;
+    while (fgets(line, sizeof(line), f)) {
+        if (!strstr(line, tag.c_str())) continue;
+        for (float &v : out.m) v = NAN;
+        for (uint8_t m = 0; m < METRIC_CNT; m++) {
+            std::string key = std::string("\"") + METRIC_NAMES[m] + "\":";
+            const char *p = strstr(line, key.c_str());
+            if (p && strncmp(p + key.size(), "null", 4) != 0) out.m[m] = strtof(p + key.size(), nullptr);
+        }
+        out.ok = strstr(line, "\"ok\":true") != nullptr;
+        found = true;
+        break;
+    }
+    fclose(f);
+    return found;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: bench [options]\n"
+        "  --only NAME        run one scenario (cold | switch | rush | noise | lowpower | planmiss | planlong)\n"
+        "  --baseline FILE    compare with a previous run and exit 1 on regression\n"
+        "  --tol PCT          allowed worsening in percent (default 5)\n"
+        "  --jobs N           scenarios run in parallel (default: online CPUs)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *only = nullptr, *baseline = nullptr;
+    float tol = 5.0f;
+    unsigned jobs = sim::cpuCount();
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--only")) only = v;
+        else if (!strcmp(a, "--baseline")) baseline = v;
+        else if (!strcmp(a, "--tol")) tol = static_cast<float>(atof(v));
+        else if (!strcmp(a, "--jobs")) jobs = static_cast<unsigned>(atoi(v));
+        else { usage(); return 2; }
+        i++;
+    }
+
+    std::vector<size_t> sel;
+    for (size_t k = 0; k < SCENARIO_CNT; k++) if (!only || !strcmp(only, scenarios[k].name)) sel.push_back(k);
+    if (sel.empty()) { usage(); return 2; }
+
+    // シナリオごとにプロセスを分けて並列実行（結果はシードで固定されるため実行順に依存しない）
+    std::vector<Result> res = sim::pool<Result>(sel.size(), jobs, [&](size_t k) { return scenarios[sel[k]].fn(); });
+
+    int regressions = 0;
+    for (size_t k = 0; k < sel.size(); k++) {
+        const char *name = scenarios[sel[k]].name;
+        printf("%s\n", toJson(name, res[k]).c_str());
+        if (!res[k].ok) { fprintf(stderr, "%s: scenario did not complete\n", name); regressions++; }
+        if (res[k].m[OVERSHOOT_C] > scenarios[sel[k]].overshootMaxC) { // NANとの比較は常に偽
+            fprintf(stderr, "OVERSHOOT %s: %.2f (max %.2f)\n", name, res[k].m[OVERSHOOT_C], scenarios[sel[k]].overshootMaxC);
+            regressions++;
+        }
+        if (res[k].m[DEADLINE_S] > scenarios[sel[k]].deadlineMaxS) {
+            fprintf(stderr, "DEADLINE %s: %.2f (max %.2f)\n", name, res[k].m[DEADLINE_S], scenarios[sel[k]].deadlineMaxS);
+            regressions++;
+        }
+        Result base;
+        if (!baseline || !readBaseline(baseline, name, base)) continue;
+        for (uint8_t m = 0; m < METRIC_CNT; m++) {
+            if (isnan(base.m[m]) || isnan(res[k].m[m])) continue;
+            float limit = base.m[m] + max(f_abs(base.m[m]) * tol / 100.0f, METRIC_SLACK[m]);
+            if (res[k].m[m] > limit) {
+                fprintf(stderr, "REGRESSION %s.%s: %.2f -> %.2f (limit %.2f)\n", name, METRIC_NAMES[m], base.m[m], res[k].m[m], limit);
+                regressions++;
+            }
+        }
+    }
+    return regressions ? 1 : 0;
+}
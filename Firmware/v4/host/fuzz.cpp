@@ -0,0 +1,430 @@
+/*********************************************************************
+ * El-Pico v4 ステートマシン・ファザー（ホスト用）
+ * ---------------------------------------------------------------
+ * 仮想時計とプラントモデルの上で、エンコーダ・ボタン・ピザ・熱電対の
+ * 故障・電源電圧・シリアルコマンドをランダム（またはスクリプト）に与え、
+ * 10msごとの loop() の後で安全上の不変条件を検査する。
+ *
+ * [不変条件]
+ *   relay     ERROR中に安全リレーがHIGH
+ *   ssr       異常確定（ゾーンのerror、またはERROR）から1制御周期を過ぎてもSSRがON
+ *   shutdown  SHUTDOWNに入って1制御周期を過ぎてもSSRがON
+ *   eeprom    1時間（仮想時間）あたりのEEPROM書き込みバイト数が上限を超えた
+ *   state     ovenが範囲外
+ *   overheat  表面の実温度がPLATE_MAX_C+20℃を3秒超えてもERRORでない
+ *   param     シリアルコマンドの後で、設定項目（PIDゲイン・band・boost等）が有限でないか範囲外
+ *   output    ゾーンのPID出力が有限の0〜255でない
+ *   trip      熱電対の断線（open）の注入から IntelligentHeater::TRIP_MAX_MS を過ぎても、そのゾーンのエラーが確定しない
+ *
+ * [入力] 操作は静かな期間（平均2分間隔）と忙しい期間（平均0.7秒間隔）を交互に生成し、
+ *   ときどき1〜5時間の不在を挟む（エコ保温・休止・冷却を通すため）。シリアルコマンドには
+ *   正しいものに加え、書式違反・範囲外の値・nan/inf・未知のキー・受信バッファを超える行・任意のバイト列を混ぜる。
+ *   熱電対の故障はアンプが検出できる種類のみ注入する（MAX6675のGND短絡は正常値に見えるため除く）
+ *
+ * [スクリプト] 1行1操作「時刻ms 操作 引数」。--trace で出力した入力列をそのまま --script に渡せる
+ *   turn +1|-1 / press HOLD_MS / load / unload / nan MS / fault up-p|up-h|lo-p|lo-h KIND MS /
+ *   mains SCALE / tune（起動時の長押しと同じチューニング確認）/ cmd TEXT...（KIND: open short-gnd short-vcc cj bus）
+ *
+ * ビルド: g++ -std=c++17 -O2 -I Firmware/v4/host -o fuzz Firmware/v4/host/fuzz.cpp
+ *
+ * 例:
+ *   ./fuzz --seeds 64 --hours 24               シード1〜64を各24時間（並列）
+ *   ./fuzz --seed 17 --hours 24 --trace > c.txt 違反したシードを再実行し入力列を保存
+ *   ./fuzz --seed 17 --script c.txt             保存した入力列を再生
+ *********************************************************************/
+#include <chrono>
+#include <string>
+
+#include "sim.h"
+
+namespace {
+
+constexpr uint32_t TICK_GRACE_MS = 1000UL + 20UL; // 1制御周期 + ループ2回分
+constexpr float    OVERHEAT_C    = Config::Hard::PLATE_MAX_C + 20.0f;
+constexpr uint32_t TRIP_MAX_MS   = IntelligentHeater::TRIP_MAX_MS + 20UL; // ファームウェアの見積もり + ループ2回分
+
+enum Violation : uint8_t { V_NONE, V_RELAY, V_SSR, V_SHUTDOWN, V_EEPROM, V_STATE, V_OVERHEAT, V_PARAM, V_OUTPUT, V_TRIP };
+const char *const VIOLATION_NAMES[] = { "none", "relay", "ssr", "shutdown", "eeprom", "state", "overheat", "param", "output", "trip" };
+
+struct Options {
+    uint32_t seeds = 16, firstSeed = 1;
+    float hours = 6.0f;
+    uint32_t eepromMax = 512;
+    unsigned jobs = sim::cpuCount();
+    bool trace = false;
+    const char *script = nullptr;
+} opt;
+
+struct Result {
+    uint64_t steps;
+    uint32_t actions;
+    uint32_t violAtMs;
+    uint32_t eepromPeak;   // 1時間あたりの書き込みバイト数の最大
+    uint32_t tripPeakMs;   // 断線の注入からエラー確定までの最大
+    uint16_t stateMask;    // 訪れたステート
+    uint8_t  viol;
+    double   wallS;
+};
+
+const uint8_t FAULT_PINS[] = { Config::Pins::CS_UP_PLATE, Config::Pins::CS_UP_HEATER,
+                               Config::Pins::CS_LO_PLATE, Config::Pins::CS_LO_HEATER };
+const char *const FAULT_PIN_NAMES[] = { "up-p", "up-h", "lo-p", "lo-h" };
+const char *const FAULT_KINDS[] = { "ok", "open", "short-gnd", "short-vcc", "cj", "bus" }; // host::TcFault順
+
+/* ================= FUZZER ================= */
+class Fuzzer {
+public:
+    sim::Runner r;
+    Result res = {};
+    std::vector<std::string> log; // 実行した操作（スクリプト形式）
+
+    explicit Fuzzer(uint32_t seed) : _rng(seed * 2654435761UL + 1) {
+        r.boot(nullptr, seed);
+        Serial.sink = nullptr; // 応答は捨てる
+        _nextActMs = millis() + 1000;
+    }
+
+    // 操作を1つ実行（スクリプトと同じ書式）。書式が不正ならfalse
+    bool apply(const char *line) {
+        char verb[16] = "", a[64] = "", b[16] = "";
+        long n = 0;
+        if (sscanf(line, "%15s", verb) != 1) return false;
+        uint32_t now = millis();
+        host::State &s = host::state();
+        if (!strcmp(verb, "turn") && sscanf(line, "%*s %ld", &n) == 1) {
+            s.pinIn[Config::Pins::ENC_DT] = (n > 0) ? HIGH : LOW;
+            s.pinIn[Config::Pins::ENC_CLK] = LOW;
+            _clkUpMs = now + 20;
+        } else if (!strcmp(verb, "press") && sscanf(line, "%*s %ld", &n) == 1) {
+            s.pinIn[Config::Pins::ENC_SW] = LOW;
+            _swUpMs = now + static_cast<uint32_t>(n);
+        } else if (!strcmp(verb, "load")) {
+            r.plant.load();
+        } else if (!strcmp(verb, "unload")) {
+            r.plant.unload();
+        } else if (!strcmp(verb, "nan") && sscanf(line, "%*s %ld", &n) == 1) {
+            r.plant.nanProb = 0.5f;
+            _nanEndMs = now + static_cast<uint32_t>(n);
+        } else if (!strcmp(verb, "fault") && sscanf(line, "%*s %63s %15s %ld", a, b, &n) == 3) {
+            int pin = -1, kind = -1;
+            for (int i = 0; i < 4; i++) if (!strcmp(a, FAULT_PIN_NAMES[i])) pin = i;
+            for (int i = 0; i < 6; i++) if (!strcmp(b, FAULT_KINDS[i])) kind = i;
+            if (pin < 0 || kind < 0) return false;
+            s.thermoFault[FAULT_PINS[pin]] = static_cast<uint8_t>(kind);
+            _faultEndMs[pin] = now + static_cast<uint32_t>(n);
+            _openSinceMs[pin] = (kind == host::TC_OPEN) ? now : 0;
+        } else if (!strcmp(verb, "tune")) { // 起動時のボタン長押しと同じ確認画面を開く
+            askConfirmation = AskConfirmation::START_TUNE;
+            confirmationYes = false;
+        } else if (!strcmp(verb, "mains")) {
+            r.plant.mainsScale = static_cast<float>(atof(line + 6));
+        } else if (!strcmp(verb, "cmd")) {
+            std::string c = std::string(line + 4) + "\n";
+            Serial.feed(c.c_str());
+            _cmdCheck = true;
+        } else {
+            return false;
+        }
+        res.actions++;
+        if (opt.trace) log.push_back(std::to_string(now) + " " + line);
+        return true;
+    }
+
+    // ランダムな操作を生成
+    void randomAction() {
+        char buf[64];
+        uint32_t w = below(100);
+        if (w < 25) snprintf(buf, sizeof(buf), "turn %+d", below(2) ? 1 : -1);
+        else if (w < 45) snprintf(buf, sizeof(buf), "press %u", 60 + below(340));          // 短押し
+        else if (w < 53) snprintf(buf, sizeof(buf), "press %u", 2100 + below(900));        // 長押し
+        else if (w < 57) snprintf(buf, sizeof(buf), "press %u", below(3000));              // 境界付近を含む
+        else if (w < 63) snprintf(buf, sizeof(buf), "load");
+        else if (w < 69) snprintf(buf, sizeof(buf), "unload");
+        else if (w < 73) snprintf(buf, sizeof(buf), "nan %u", 500 + below(5000));
+        else if (w < 77) {
+            uint8_t kind;
+            do { kind = static_cast<uint8_t>(1 + below(5)); } // MAX6675はVCC短絡/冷接点異常を報告できないが、読み値の張り付き/正常値として扱える
+            while (kind == host::TC_SHORT_GND && Config::Thermo::CHIP == Config::Thermo::MAX6675);
+            snprintf(buf, sizeof(buf), "fault %s %s %u", FAULT_PIN_NAMES[below(4)], FAULT_KINDS[kind], 500 + below(10000));
+        } else if (w < 80) snprintf(buf, sizeof(buf), "mains %.2f", 0.8f + below(41) / 100.0f);
+        else if (w < 81) snprintf(buf, sizeof(buf), "tune");
+        else snprintf(buf, sizeof(buf), "cmd %s", randomCommand().c_str());
+        apply(buf);
+    }
+
+    // 1ステップ進めて不変条件を検査（違反があればその種類）
+    uint8_t step() {
+        uint32_t now = millis();
+        host::State &s = host::state();
+        if (_clkUpMs && now >= _clkUpMs) { s.pinIn[Config::Pins::ENC_CLK] = HIGH; _clkUpMs = 0; }
+        if (_swUpMs && now >= _swUpMs) { s.pinIn[Config::Pins::ENC_SW] = HIGH; _swUpMs = 0; }
+        if (_nanEndMs && now >= _nanEndMs) { r.plant.nanProb = 0.0f; _nanEndMs = 0; }
+        for (uint8_t i = 0; i < 4; i++)
+            if (_faultEndMs[i] && now >= _faultEndMs[i]) { s.thermoFault[FAULT_PINS[i]] = host::TC_OK; _faultEndMs[i] = _openSinceMs[i] = 0; }
+
+        r.step();
+        res.steps++;
+        return check();
+    }
+
+    // ランダム入力で指定時間だけ実行
+    void fuzz(uint32_t ms) {
+        uint32_t end = millis() + ms;
+        while (millis() < end) {
+            if (millis() >= _nextActMs) {
+                if (below(10) == 0) _busy = !_busy; // 忙しい期間と静かな期間を切り替える
+                randomAction();
+                uint32_t mean = _busy ? 700UL : 120000UL;
+                _nextActMs = millis() + 10 + static_cast<uint32_t>(-logf(1.0f - below(10000) / 10000.0f) * mean);
+                if (below(300) == 0) _nextActMs += 3600000UL + below(5) * 3600000UL; // 1〜5時間の不在（エコ保温→休止）
+            }
+            if ((res.viol = step()) != V_NONE) return;
+        }
+    }
+
+    // スクリプトを実行（最後の操作の後、settleMsだけ様子を見る）
+    bool script(FILE *f, uint32_t settleMs) {
+        char line[160];
+        while (fgets(line, sizeof(line), f)) {
+            char *p = line;
+            while (*p == ' ' || *p == '\t') p++;
+            if (*p == '#' || *p == '\n' || *p == '\0') continue;
+            line[strcspn(line, "\r\n")] = '\0';
+            char *rest;
+            uint32_t at = static_cast<uint32_t>(strtoul(p, &rest, 10));
+            while (*rest == ' ') rest++;
+            while (millis() < at) if ((res.viol = step()) != V_NONE) return true;
+            if (!apply(rest)) { fprintf(stderr, "bad script line: %s\n", line); return false; }
+        }
+        uint32_t end = millis() + settleMs;
+        while (millis() < end) if ((res.viol = step()) != V_NONE) return true;
+        return true;
+    }
+
+private:
+    uint8_t check() {
+        uint32_t now = millis();
+        host::State &s = host::state();
+        uint8_t st = static_cast<uint8_t>(oven);
+        if (st >= OVEN_STATE_CNT) return fail(V_STATE);
+        res.stateMask |= 1u << st;
+
+        bool ssrOn = s.pinOut[Config::Pins::SSR_UP] || s.pinOut[Config::Pins::SSR_LO];
+        if (oven == OvenState::ERROR && s.pinOut[Config::Pins::SAFETY_RELAY]) return fail(V_RELAY);
+
+        bool faulted = oven == OvenState::ERROR || anyZoneError();
+        if (!faulted) _errSinceMs = 0;
+        else if (!_errSinceMs) _errSinceMs = now;
+        if (_errSinceMs && now - _errSinceMs > TICK_GRACE_MS && ssrOn) return fail(V_SSR);
+
+        if (oven != OvenState::SHUTDOWN) _shutSinceMs = 0;
+        else if (!_shutSinceMs) _shutSinceMs = now;
+        if (_shutSinceMs && now - _shutSinceMs > TICK_GRACE_MS && ssrOn) return fail(V_SHUTDOWN);
+
+        // EEPROM: 仮想時間1時間ごとの書き込みバイト数
+        uint32_t wr = s.eepromWrites - _hourWrites;
+        if (wr > res.eepromPeak) res.eepromPeak = wr;
+        if (wr > opt.eepromMax) return fail(V_EEPROM);
+        if (now - _hourStartMs >= 3600000UL) { _hourStartMs = now; _hourWrites = s.eepromWrites; }
+
+        bool hot = r.plant.up.surfC > OVERHEAT_C || r.plant.lo.surfC > OVERHEAT_C;
+        if (!hot || oven == OvenState::ERROR) _hotSinceMs = 0;
+        else if (!_hotSinceMs) _hotSinceMs = now;
+        if (_hotSinceMs && now - _hotSinceMs > 3000UL) return fail(V_OVERHEAT);
+
+        // 断線はゾーンのエラー（ERROR中は確定済み）になるまでの時間を計る。解除や確定で計測を終える
+        for (uint8_t i = 0; i < 4; i++) {
+            if (!_openSinceMs[i]) continue;
+            uint8_t z = (i < 2) ? Config::Zones::UP : Config::Zones::LO;
+            uint32_t t = now - _openSinceMs[i];
+            if ((zones[z].error & 1) || oven == OvenState::ERROR) {
+                if (t > res.tripPeakMs) res.tripPeakMs = t;
+                _openSinceMs[i] = 0;
+            } else if (t > TRIP_MAX_MS) return fail(V_TRIP);
+        }
+
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+            float u = zones[i].pidOut();
+            if (!(u >= 0.0f && u <= 255.0f)) return fail(V_OUTPUT);
+        }
+
+        if (_cmdCheck) { _cmdCheck = false; if (!paramsInRange()) return fail(V_PARAM); } // コマンドは次のloop()で処理済み
+        return V_NONE;
+    }
+
+    // Settingsにある項目（ゾーンごとの項目は全ゾーン）がすべて有限かつ設定できる範囲内か
+    static bool paramsInRange() {
+        for (uint8_t i = 0; i < Cmd::PARAM_CNT; i++) {
+            Cmd::Param p;
+            memcpy_P(&p, &Cmd::params[i], sizeof(p));
+            if (p.type == Cmd::RCP || p.type == Cmd::LIFE) continue; // レシピ値・消耗度はSettingsの外
+            for (uint8_t z = 0; z < ((p.key[0] == '*') ? Config::Zones::CNT : 1); z++) {
+                Cmd::Param q = p;
+                if (p.key[0] == '*') Cmd::bindZone(q, z);
+                float v = Cmd::read(q);
+                if (!(v >= q.lo && v <= q.hi)) return false;
+            }
+        }
+        return true;
+    }
+
+    uint8_t fail(uint8_t v) { res.violAtMs = millis(); return v; }
+
+    std::string randomCommand() {
+        char buf[48];
+        static const char *const NONFINITE[] = { "nan", "inf", "-inf", "NAN", "-nan", "infinity" };
+        static const char *const FLOAT_KEYS[] = { "up.kp", "lo.ki", "up.kd", "band" };
+        switch (below(16)) {
+            case 0:  return "save";
+            case 1:  return "revert";
+            case 2:  return "list";
+            case 3:  snprintf(buf, sizeof(buf), "set boost %u", below(301)); break;
+            case 4:  snprintf(buf, sizeof(buf), "set recipe %u", below(Config::RECIPE_CNT)); break;
+            case 5:  snprintf(buf, sizeof(buf), "set limit %u", below(Config::LIMIT_CNT)); break;
+            case 6:  snprintf(buf, sizeof(buf), "set %s.kp %.2f", below(2) ? "up" : "lo", below(5001) / 100.0f); break;
+            case 7:  snprintf(buf, sizeof(buf), "set r.up %u", 200 + below(450)); break;
+            case 8:  snprintf(buf, sizeof(buf), "set h.cap %u", 600 + below(221)); break;
+            case 9:  snprintf(buf, sizeof(buf), "set band %u", 1 + below(30)); break;
+            case 10: snprintf(buf, sizeof(buf), "set %s.wear %u", below(2) ? "up" : "lo", below(101)); break;
+            case 11: snprintf(buf, sizeof(buf), "ready %u", below(4) ? 10 + below(240) : 0); break;
+            case 12: snprintf(buf, sizeof(buf), "set %s %s", FLOAT_KEYS[below(4)], NONFINITE[below(6)]); break;
+            case 13:
+            case 14: return badCommand();
+            default: return "bogus 1";
+        }
+        return buf;
+    }
+
+    // 不正な入力（書式違反・範囲外・未知のキー・受信バッファを超える行・改行以外の任意のバイト）
+    std::string badCommand() {
+        static const char *const BAD[] = {
+            "set", "get", "set up.kp", "set band 5x", "set up.kp 1.2.3", "set band --1", "set recipe 0x10", "SET band 5",
+            "set band 1e9", "set up.kp -1", "set lo.ki 1e-50", "set recipe 255", "set limit 99", "set h.cap 10",
+            "set r.bake 0", "set soak 101", "ready -5", "ready 99999", "ready abc", "ready", "ready 1e3",
+            "set foo 1", "get zz.kp", "set up.zz 1", "get .kp", "set up. 1", "get up.kp.kp", "set . 1", "get *.kp",
+        };
+        std::string s;
+        switch (below(4)) {
+            case 0:
+            case 1: return BAD[below(sizeof(BAD) / sizeof(BAD[0]))];
+            case 2: // Cmd::LINE_LEN を超える行
+                s = below(2) ? "set band " : "ready ";
+                for (uint32_t n = Cmd::LINE_LEN + below(64); s.size() < n;) s += static_cast<char>('0' + below(10));
+                return s;
+            default:
+                for (uint32_t n = 1 + below(40); n; n--) {
+                    char c;
+                    do { c = static_cast<char>(1 + below(255)); } while (c == '\n' || c == '\r');
+                    s += c;
+                }
+                return s;
+        }
+    }
+
+    uint32_t below(uint32_t n) {
+        _rng ^= _rng << 13; _rng ^= _rng >> 17; _rng ^= _rng << 5;
+        return n ? _rng % n : 0;
+    }
+
+    uint32_t _rng;
+    bool _busy = false;
+    uint32_t _nextActMs = 0, _clkUpMs = 0, _swUpMs = 0, _nanEndMs = 0, _faultEndMs[4] = {}, _openSinceMs[4] = {};
+    bool _cmdCheck = false;
+    uint32_t _errSinceMs = 0, _shutSinceMs = 0, _hotSinceMs = 0, _hourStartMs = 0, _hourWrites = 0;
+};
+
+std::string stateList(uint16_t mask, bool visited) {
+    static const char *const NAMES[] = { "IDLE", "PREHEAT", "READY", "BAKING", "BAKE_DONE", "REST",
+                                         "COOLING", "SHUTDOWN", "ERROR", "TUNING", "ECO", "PLANNED" };
+    std::string s;
+    for (uint8_t i = 0; i < OVEN_STATE_CNT && i < sizeof(NAMES) / sizeof(NAMES[0]); i++)
+        if (((mask >> i) & 1) == visited) s += std::string(s.empty() ? "" : " ") + NAMES[i];
+    return s.empty() ? "-" : s;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: fuzz [options]\n"
+        "  --seeds N          fuzz seeds 1..N in parallel (default 16)\n"
+        "  --seed S           fuzz a single seed (also the plant seed for --script)\n"
+        "  --hours H          simulated hours per seed (default 6)\n"
+        "  --eeprom-max N     allowed EEPROM bytes written per simulated hour (default 512)\n"
+        "  --jobs N           seeds run in parallel (default: online CPUs)\n"
+        "  --trace            print the input sequence of a single seed as a script\n"
+        "  --script FILE      replay a script instead of random inputs\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--trace")) { opt.trace = true; continue; }
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--seeds")) opt.seeds = static_cast<uint32_t>(atoi(v));
+        else if (!strcmp(a, "--seed")) { opt.firstSeed = static_cast<uint32_t>(atoi(v)); opt.seeds = 1; }
+        else if (!strcmp(a, "--hours")) opt.hours = static_cast<float>(atof(v));
+        else if (!strcmp(a, "--eeprom-max")) opt.eepromMax = static_cast<uint32_t>(atoi(v));
+        else if (!strcmp(a, "--jobs")) opt.jobs = static_cast<unsigned>(atoi(v));
+        else if (!strcmp(a, "--script")) opt.script = v;
+        else { usage(); return 2; }
+        i++;
+    }
+    if (opt.seeds == 0 || (opt.trace && opt.seeds != 1)) { usage(); return 2; }
+
+    // スクリプト再生（1プロセス）
+    if (opt.script) {
+        FILE *f = fopen(opt.script, "r");
+        if (!f) { perror(opt.script); return 2; }
+        Fuzzer fz(opt.firstSeed);
+        bool ok = fz.script(f, 60000UL);
+        fclose(f);
+        if (!ok) return 2;
+        printf("script: %llu steps, %u actions, eeprom peak %u B/h, states %s\n",
+               static_cast<unsigned long long>(fz.res.steps), fz.res.actions, fz.res.eepromPeak,
+               stateList(fz.res.stateMask, true).c_str());
+        if (fz.res.viol) printf("VIOLATION %s at %u ms\n", VIOLATION_NAMES[fz.res.viol], fz.res.violAtMs);
+        return fz.res.viol ? 1 : 0;
+    }
+
+    uint32_t runMs = static_cast<uint32_t>(opt.hours * 3600000.0f);
+    auto job = [&](size_t k) {
+        auto t0 = std::chrono::steady_clock::now();
+        Fuzzer fz(opt.firstSeed + static_cast<uint32_t>(k));
+        fz.fuzz(runMs);
+        fz.res.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (opt.trace) for (const std::string &l : fz.log) printf("%s\n", l.c_str());
+        return fz.res;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Result> res;
+    if (opt.trace) res.push_back(job(0)); // 入力列を標準出力に出すため同一プロセスで実行
+    else res = sim::pool<Result>(opt.seeds, opt.jobs, job);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    uint64_t steps = 0;
+    uint32_t actions = 0, eepromPeak = 0, tripPeak = 0, failed = 0;
+    uint16_t mask = 0;
+    for (size_t k = 0; k < res.size(); k++) {
+        const Result &r = res[k];
+        steps += r.steps; actions += r.actions; mask |= r.stateMask;
+        if (r.eepromPeak > eepromPeak) eepromPeak = r.eepromPeak;
+        if (r.tripPeakMs > tripPeak) tripPeak = r.tripPeakMs;
+        if (r.viol) {
+            failed++;
+            fprintf(stderr, "seed %u: VIOLATION %s at %u ms (reproduce: --seed %u --hours %.2f --trace)\n",
+                    opt.firstSeed + static_cast<uint32_t>(k), VIOLATION_NAMES[r.viol], r.violAtMs,
+                    opt.firstSeed + static_cast<uint32_t>(k), r.violAtMs / 3600000.0f + 0.01f);
+        }
+    }
+    FILE *out = opt.trace ? stderr : stdout;
+    fprintf(out, "%zu seeds, %.1f sim hours, %llu steps (%.1f M steps/s), %u actions, %u failed\n",
+            res.size(), steps * 10.0 / 3600000.0, static_cast<unsigned long long>(steps), steps / wall / 1e6, actions, failed);
+    fprintf(out, "eeprom peak %u B/h (limit %u)\n", eepromPeak, opt.eepromMax);
+    fprintf(out, "open-circuit trip peak %u ms (limit %u)\n", tripPeak, TRIP_MAX_MS);
+    fprintf(out, "states visited: %s\n", stateList(mask, true).c_str());
+    fprintf(out, "never visited:  %s\n", stateList(mask, false).c_str());
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,233 @@
+/*********************************************************************
+ * El-Pico v4 パラメーター最適化ツール（ホスト用）
+ * ---------------------------------------------------------------
+ * ファームウェアをシミュレーター上で営業シナリオごと走らせ、PIDゲイン・
+ * Boost時間・READY判定条件の組み合わせを全CPUコアで並列に総当たり評価する。
+ * 最良の設定は EEPROM イメージ（.bin / Intel HEX）として書き出す。
+ *
+ * ビルド: g++ -std=c++17 -O2 -I Firmware/v4/host -o optimize Firmware/v4/host/optimize.cpp
+ * 書込み: avrdude -p m32u4 -c avr109 -P <port> -U eeprom:w:best.hex:i
+ *
+ * 例:
+ *   ./optimize --up-kp 2:6:5 --lo-kp 2:6:5 --boost 0:120:4
+ *   ./optimize --random 400 --scenario all --jobs 16 --out tuned
+ *********************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+#include "sim.h"
+
+namespace {
+
+/* ================= SEARCH SPACE ================= */
+enum Param : uint8_t { UP_KP, UP_KI, UP_KD, LO_KP, LO_KI, LO_KD, BOOST_S, BAND_C, SOAK_PCT, PARAM_CNT };
+
+struct Axis { const char *opt; float lo, hi; uint16_t n; };
+
+// 既定値は defaultSettings() と同じ1点（指定した軸だけが掃引される）
+Axis axes[PARAM_CNT] = {
+    { "--up-kp", 3.5f, 3.5f, 1 }, { "--up-ki", 0.05f, 0.05f, 1 }, { "--up-kd", 1.0f, 1.0f, 1 },
+    { "--lo-kp", 3.5f, 3.5f, 1 }, { "--lo-ki", 0.05f, 0.05f, 1 }, { "--lo-kd", 1.0f, 1.0f, 1 },
+    { "--boost", 60.0f, 60.0f, 1 }, { "--band", 5.0f, 5.0f, 1 }, { "--soak", 95.0f, 95.0f, 1 },
+};
+
+float axisValue(const Axis &a, uint16_t i) {
+    return (a.n <= 1) ? a.lo : a.lo + (a.hi - a.lo) * i / (a.n - 1);
+}
+
+struct Candidate { float v[PARAM_CNT]; };
+
+Settings toSettings(const Candidate &c) {
+    Settings s = defaultSettings();
+    ZoneTuning &u = s.zone[Config::Zones::UP], &l = s.zone[Config::Zones::LO];
+    u.kp = c.v[UP_KP]; u.ki = c.v[UP_KI]; u.kd = c.v[UP_KD];
+    l.kp = c.v[LO_KP]; l.ki = c.v[LO_KI]; l.kd = c.v[LO_KD];
+    s.boostSec = static_cast<uint16_t>(c.v[BOOST_S] + 0.5f);
+    s.readyBandC = c.v[BAND_C];
+    s.soakReadyPct = static_cast<uint8_t>(c.v[SOAK_PCT] + 0.5f);
+    return s;
+}
+
+/* ================= SCENARIOS ================= */
+struct Scenario {
+    const char *name;
+    uint8_t recipeIdx, limitIdx;
+    float mainsScale;   // 電源電圧の変動（電力比）
+    float ambientC;
+};
+
+const Scenario scenarios[] = {
+    { "napoli",   0, 0, 1.00f, 25.0f },
+    { "romana",   1, 0, 1.00f, 25.0f },
+    { "lowpower", 0, 1, 0.95f, 15.0f }, // 電力制限 + 電圧降下 + 寒い屋外
+};
+constexpr uint8_t SCENARIO_CNT = sizeof(scenarios) / sizeof(scenarios[0]);
+
+/* ================= SCORING ================= */
+struct Weights { float pph = 10.0f, wh = 0.05f, overshoot = 0.5f, stress = 2.0f, cv = 200.0f, miss = 20.0f; } weights;
+
+struct Eval {
+    sim::ServiceResult s[SCENARIO_CNT];
+    float score;
+    bool  ok;
+};
+
+uint16_t pizzas = 30;
+uint32_t intervalMs = 120000UL;
+uint8_t scenarioMask = 1;
+
+// 高いほど良い。各シナリオの平均
+float score(const sim::ServiceResult &r) {
+    if (!r.ok) return -1e6f;
+    return weights.pph * r.pph - weights.wh * r.whPerPizza - weights.overshoot * r.overshootC
+         - weights.stress * r.overHeaterS - weights.cv * r.doseCv - weights.miss * r.missed;
+}
+
+// ファームウェアの状態はプロセス内で1台分しか持てないため、候補×シナリオを1ジョブとして実行する
+sim::ServiceResult evaluate(const Candidate &c, uint8_t k) {
+    Settings st = toSettings(c);
+    st.recipeIdx = scenarios[k].recipeIdx;
+    st.limitIdx = scenarios[k].limitIdx;
+    sim::Runner r;
+    r.plant.mainsScale = scenarios[k].mainsScale;
+    r.plant.ambientC = scenarios[k].ambientC;
+    r.boot(&st, 1234 + k);
+    return sim::runService(r, pizzas, intervalMs);
+}
+
+/* ================= CLI ================= */
+bool parseAxis(Axis &a, const char *spec) {
+    float lo, hi; unsigned n;
+    if (sscanf(spec, "%f:%f:%u", &lo, &hi, &n) == 3 && n >= 1 && n <= 1000) { a.lo = lo; a.hi = hi; a.n = static_cast<uint16_t>(n); return true; }
+    if (sscanf(spec, "%f", &lo) == 1) { a.lo = a.hi = lo; a.n = 1; return true; }
+    return false;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: optimize [options]\n"
+        "  --up-kp|--up-ki|--up-kd|--lo-kp|--lo-ki|--lo-kd|--boost|--band|--soak  START:END:COUNT | VALUE\n"
+        "  --random N         sample N random points in the given ranges instead of the full grid\n"
+        "  --scenario NAME    napoli | romana | lowpower | all (default napoli)\n"
+        "  --pizzas N         pizzas per service (default 30)\n"
+        "  --interval SEC     pizza arrival interval (default 120)\n"
+        "  --jobs N           worker processes (default: online CPUs)\n"
+        "  --top K            rows to print (default 10)\n"
+        "  --out PREFIX       write best settings to PREFIX.bin / PREFIX.hex (default best)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned jobs = sim::cpuCount(), top = 10, random = 0;
+    std::string out = "best";
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool used = false;
+        for (Axis &ax : axes) {
+            if (!strcmp(a, ax.opt)) {
+                if (!v || !parseAxis(ax, v)) { usage(); return 2; }
+                used = true; break;
+            }
+        }
+        if (used) { i++; continue; }
+        if (!v && strcmp(a, "-h") && strcmp(a, "--help")) { usage(); return 2; }
+        if (!strcmp(a, "--random")) random = static_cast<unsigned>(atoi(v));
+        else if (!strcmp(a, "--pizzas")) pizzas = static_cast<uint16_t>(atoi(v));
+        else if (!strcmp(a, "--interval")) intervalMs = static_cast<uint32_t>(atof(v) * 1000.0);
+        else if (!strcmp(a, "--jobs")) jobs = static_cast<unsigned>(atoi(v));
+        else if (!strcmp(a, "--top")) top = static_cast<unsigned>(atoi(v));
+        else if (!strcmp(a, "--out")) out = v;
+        else if (!strcmp(a, "--scenario")) {
+            scenarioMask = 0;
+            for (uint8_t k = 0; k < SCENARIO_CNT; k++) if (!strcmp(v, scenarios[k].name)) scenarioMask = 1 << k;
+            if (!strcmp(v, "all")) scenarioMask = (1 << SCENARIO_CNT) - 1;
+            if (!scenarioMask) { usage(); return 2; }
+        } else { usage(); return 2; }
+        i++;
+    }
+    if (pizzas == 0) { usage(); return 2; }
+
+    // 候補の生成（全格子 or 一様乱数）
+    std::vector<Candidate> cands;
+    if (random) {
+        sim::Plant rng; rng.seed(0xC0FFEE);
+        for (unsigned k = 0; k < random; k++) {
+            Candidate c;
+            for (uint8_t p = 0; p < PARAM_CNT; p++) c.v[p] = axes[p].lo + (axes[p].hi - axes[p].lo) * rng.uniform();
+            cands.push_back(c);
+        }
+    } else {
+        size_t total = 1;
+        for (const Axis &ax : axes) total *= ax.n;
+        if (total > 1000000) { fprintf(stderr, "grid too large (%zu points), use --random\n", total); return 2; }
+        for (size_t k = 0; k < total; k++) {
+            Candidate c; size_t rem = k;
+            for (uint8_t p = 0; p < PARAM_CNT; p++) { c.v[p] = axisValue(axes[p], static_cast<uint16_t>(rem % axes[p].n)); rem /= axes[p].n; }
+            cands.push_back(c);
+        }
+    }
+
+    std::vector<uint8_t> scen;
+    for (uint8_t k = 0; k < SCENARIO_CNT; k++) if (scenarioMask & (1 << k)) scen.push_back(k);
+    const size_t total = cands.size() * scen.size();
+    fprintf(stderr, "%zu candidates x %zu scenario(s), %u workers\n", cands.size(), scen.size(), jobs);
+    size_t done = 0;
+    std::vector<sim::ServiceResult> runs = sim::pool<sim::ServiceResult>(total, jobs,
+        [&](size_t j) { return evaluate(cands[j / scen.size()], scen[j % scen.size()]); },
+        [&](size_t, const sim::ServiceResult &) { if (++done % 10 == 0 || done == total) fprintf(stderr, "\r%zu/%zu", done, total); });
+    fprintf(stderr, "\n");
+
+    // シナリオごとの結果を候補単位に集計（スコアは平均）
+    std::vector<Eval> res(cands.size());
+    for (size_t c = 0; c < cands.size(); c++) {
+        Eval &e = res[c];
+        e.ok = true;
+        float sum = 0;
+        for (size_t i = 0; i < scen.size(); i++) {
+            const sim::ServiceResult &r = runs[c * scen.size() + i];
+            e.s[scen[i]] = r;
+            e.ok = e.ok && r.ok;
+            sum += score(r);
+        }
+        e.score = sum / scen.size();
+    }
+
+    std::vector<size_t> order(cands.size());
+    for (size_t k = 0; k < order.size(); k++) order[k] = k;
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return res[x].score > res[y].score; });
+
+    printf("%-4s %8s %6s %6s %6s %6s %6s %6s %5s %5s %4s | %6s %7s %6s %6s %6s %4s\n",
+           "rank", "score", "upKp", "upKi", "upKd", "loKp", "loKi", "loKd", "boost", "band", "soak",
+           "pph", "Wh/pz", "ovrC", "hotS", "doseCV", "miss");
+    for (size_t r = 0; r < order.size() && r < top; r++) {
+        const Candidate &c = cands[order[r]];
+        const Eval &e = res[order[r]];
+        // 複数シナリオ時は平均値を表示
+        float pph = 0, wh = 0, ov = 0, hot = 0, cv = 0; unsigned miss = 0, n = 0;
+        for (uint8_t k = 0; k < SCENARIO_CNT; k++) {
+            if (!(scenarioMask & (1 << k))) continue;
+            pph += e.s[k].pph; wh += e.s[k].whPerPizza; ov = std::max(ov, e.s[k].overshootC);
+            hot += e.s[k].overHeaterS; cv += e.s[k].doseCv; miss += e.s[k].missed; n++;
+        }
+        printf("%-4zu %8.1f %6.2f %6.3f %6.2f %6.2f %6.3f %6.2f %5.0f %5.1f %4.0f | %6.1f %7.1f %6.1f %6.0f %6.3f %4u%s\n",
+               r + 1, e.score, c.v[UP_KP], c.v[UP_KI], c.v[UP_KD], c.v[LO_KP], c.v[LO_KI], c.v[LO_KD],
+               c.v[BOOST_S], c.v[BAND_C], c.v[SOAK_PCT], pph / n, wh / n, ov, hot / n, cv / n, miss, e.ok ? "" : " FAIL");
+    }
+
+    if (order.empty() || !res[order[0]].ok) { fprintf(stderr, "no candidate completed the service\n"); return 1; }
+
+    // 最良の設定をEEPROMイメージとして書き出す（レシピ/電力制限は既定値のまま）
+    Settings best = toSettings(cands[order[0]]);
+    std::string bin = out + ".bin", hex = out + ".hex";
+    FILE *f = fopen(bin.c_str(), "wb");
+    if (!f || fwrite(&best, sizeof(best), 1, f) != 1) { perror(bin.c_str()); return 1; }
+    fclose(f);
+    if (!sim::writeIntelHex(hex.c_str(), &best, sizeof(best))) { perror(hex.c_str()); return 1; }
+    fprintf(stderr, "best settings written to %s / %s (%zu bytes)\n", bin.c_str(), hex.c_str(), sizeof(best));
+    return 0;
+}
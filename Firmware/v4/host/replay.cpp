@@ -0,0 +1,380 @@
+/*********************************************************************
+ * El-Pico v4 テレメトリ・リプレイツール（ホスト用）
+ * ---------------------------------------------------------------
+ * debugTelemetry のシリアルログ（US: LS: UP: LP: UH: LH: UW: LW: SK: ST: ... LM:）
+ * を現在のファームウェアに流し込み、記録されたPWM・ステート遷移との差分を出す。
+ * 制御ロジックを変更した際に、実機に書き込む前に過去の運転で挙動を比較できる。
+ *
+ * [読み込み] ログはmmapで読み、行をコピーせずにその場で数値化する（GB級でも数秒）
+ * [温度の再現] ログのUP/LPはフィルタ後の値のため、フィルタ(0.8/0.2)を逆算した生温度を
+ *   熱電対に与え、リプレイ側のplateCが記録値を再現するようにする
+ * [同期] 操作によるステート変化はログに残らないため、既定では差分を報告した後に
+ *   記録側のステートへ合わせる（--free で同期せず独立に走らせる）。電力上限は記録ごとのLMに追従する
+ *
+ * ビルド: g++ -std=c++17 -O2 -I Firmware/v4/host -o replay Firmware/v4/host/replay.cpp
+ *
+ * 例:
+ *   ./replay log.txt
+ *   ./replay --settings best.bin --max-diffs 50 day1.txt day2.txt
+ *********************************************************************/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+
+#include "sim.h"
+
+namespace {
+
+/* ================= PARSER ================= */
+enum Field : uint8_t { F_US, F_LS, F_UP, F_LP, F_UH, F_LH, F_UW, F_LW, F_ST, F_LM, FIELD_CNT };
+constexpr uint16_t REQUIRED = (1 << F_UP) | (1 << F_LP) | (1 << F_UH) | (1 << F_LH) | (1 << F_UW) | (1 << F_LW) | (1 << F_ST);
+
+struct Record {
+    float v[FIELD_CNT];
+    uint16_t mask; // 取得できた項目
+};
+
+inline int8_t fieldOf(char a, char b) {
+    switch ((a << 8) | b) {
+        case ('U' << 8) | 'S': return F_US; case ('L' << 8) | 'S': return F_LS;
+        case ('U' << 8) | 'P': return F_UP; case ('L' << 8) | 'P': return F_LP;
+        case ('U' << 8) | 'H': return F_UH; case ('L' << 8) | 'H': return F_LH;
+        case ('U' << 8) | 'W': return F_UW; case ('L' << 8) | 'W': return F_LW;
+        case ('S' << 8) | 'T': return F_ST; case ('L' << 8) | 'M': return F_LM;
+        default: return -1;
+    }
+}
+
+// Serial.print(float) の出力（"-12.34", "nan", "inf", "ovf"）を読む。失敗時はpを進めない
+inline bool parseNum(const char *&p, const char *end, float &out) {
+    const char *s = p;
+    bool neg = false;
+    if (s < end && *s == '-') { neg = true; s++; }
+    if (s + 3 <= end && (s[0] == 'n' || s[0] == 'i' || s[0] == 'o')) {
+        if (!memcmp(s, "nan", 3) || !memcmp(s, "inf", 3) || !memcmp(s, "ovf", 3)) { out = NAN; p = s + 3; return true; }
+        return false;
+    }
+    uint32_t ip = 0; uint32_t fp = 0, div = 1; bool any = false;
+    while (s < end && *s >= '0' && *s <= '9') { ip = ip * 10 + static_cast<uint32_t>(*s++ - '0'); any = true; }
+    if (s < end && *s == '.') {
+        s++;
+        while (s < end && *s >= '0' && *s <= '9') {
+            if (div < 100000000UL) { fp = fp * 10 + static_cast<uint32_t>(*s - '0'); div *= 10; }
+            s++; any = true;
+        }
+    }
+    if (!any) return false;
+    float v = ip + static_cast<float>(fp) / div;
+    out = neg ? -v : v;
+    p = s;
+    return true;
+}
+
+// 1行を解析。キャプチャツールが付けたタイムスタンプ等の前置きや未知の項目は読み飛ばす
+inline bool parseLine(const char *p, const char *end, Record &r) {
+    r.mask = 0;
+    while (p + 3 <= end) {
+        if (p[2] == ':' && p[0] >= 'A' && p[0] <= 'Z' && p[1] >= 'A' && p[1] <= 'Z') {
+            int8_t f = fieldOf(p[0], p[1]);
+            const char *q = p + 3;
+            float v;
+            if (f >= 0 && parseNum(q, end, v)) { r.v[f] = v; r.mask |= 1 << f; p = q; continue; }
+            p += 3;
+        } else {
+            p++;
+        }
+    }
+    return (r.mask & REQUIRED) == REQUIRED;
+}
+
+// mmapしたログを1行ずつ走査する
+class LogReader {
+public:
+    bool open(const char *path) {
+        _fd = ::open(path, O_RDONLY);
+        if (_fd < 0) return false;
+        struct stat st;
+        if (fstat(_fd, &st) != 0) return false;
+        _len = static_cast<size_t>(st.st_size);
+        if (_len == 0) { _p = _end = nullptr; return true; }
+        void *m = mmap(nullptr, _len, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (m == MAP_FAILED) return false;
+        madvise(m, _len, MADV_SEQUENTIAL);
+        _base = static_cast<const char *>(m);
+        rewind();
+        return true;
+    }
+    ~LogReader() {
+        if (_base) munmap(const_cast<char *>(_base), _len);
+        if (_fd >= 0) close(_fd);
+    }
+
+    void rewind() { _p = _base; _end = _base + _len; lineNo = 0; }
+
+    // 次の行 [b, e)（改行/CRを除く）。終端でfalse
+    bool next(const char *&b, const char *&e) {
+        if (_p >= _end) return false;
+        b = _p;
+        const char *nl = static_cast<const char *>(memchr(_p, '\n', static_cast<size_t>(_end - _p)));
+        e = nl ? nl : _end;
+        _p = nl ? nl + 1 : _end;
+        if (e > b && e[-1] == '\r') e--;
+        lineNo++;
+        return true;
+    }
+
+    size_t bytes() const { return _len; }
+    uint64_t lineNo = 0;
+
+private:
+    int _fd = -1;
+    const char *_base = nullptr, *_p = nullptr, *_end = nullptr;
+    size_t _len = 0;
+};
+
+/* ================= REPLAY ================= */
+struct Options {
+    const char *settingsPath = nullptr;
+    int recipe = -1, limit = -1;       // -1: ログから推定
+    int tol = 0;                       // PWM差の許容値
+    unsigned maxDiffs = 20;
+    bool free = false;
+};
+Options opt;
+
+struct Summary {
+    uint64_t lines, records, pwmDiffUp, pwmDiffLo, stateDiffS, recTransitions, newTransitions, limitChanges;
+    double absUp, absLo, recUpWh, recLoWh, newUpWh, newLoWh;
+    int maxUp, maxLo;
+    uint8_t recipe, limit;
+    bool ok;
+};
+
+const char *const STATE_NAMES[] = {
+    "IDLE", "PREHEAT", "READY", "BAKING", "BAKE_DONE", "REST", "COOLING", "SHUTDOWN", "ERROR", "TUNING", "ECO", "PLANNED"
+};
+const char *stateName(int s) { return (s >= 0 && s < OVEN_STATE_CNT) ? STATE_NAMES[s] : "?"; }
+
+// 記録された電力上限 LM と一致する制限の番号（無ければ -1）
+int limitOf(const Record &r) {
+    if (!(r.mask & (1 << F_LM))) return -1;
+    for (uint8_t i = 0; i < Config::LIMIT_CNT; i++) {
+        Config::Limit lim; memcpy_P(&lim, &Config::limits[i], sizeof(lim));
+        if (f_abs(lim.watts - r.v[F_LM]) < 1.0f) return i;
+    }
+    return -1;
+}
+
+// 記録された目標温度と一致するレシピ、最初の記録の電力上限と一致する制限を探す
+// （制限は再生中も記録ごとに追従する）
+void detectSettings(LogReader &log, uint8_t &recipe, uint8_t &limit) {
+    const char *b, *e;
+    Record r;
+    bool haveLimit = false;
+    while (log.next(b, e)) {
+        if (!parseLine(b, e, r)) continue;
+        if (!haveLimit && limitOf(r) >= 0) { limit = static_cast<uint8_t>(limitOf(r)); haveLimit = true; }
+        int st = static_cast<int>(r.v[F_ST]);
+        if (st != static_cast<int>(OvenState::PREHEAT) && st != static_cast<int>(OvenState::READY)) continue;
+        if ((r.mask & ((1 << F_US) | (1 << F_LS))) != ((1 << F_US) | (1 << F_LS))) continue;
+        for (uint8_t i = 0; i < Config::RECIPE_CNT; i++) {
+            RecipeRef rr{ i };
+            if (f_abs(rr.upC() - r.v[F_US]) < 0.5f && f_abs(rr.loC() - r.v[F_LS]) < 0.5f) { recipe = i; log.rewind(); return; }
+        }
+    }
+    log.rewind();
+}
+
+// 記録側のステートへ合わせる（操作起因の遷移を再現するため）
+void syncState(int st) {
+    OvenState target = static_cast<OvenState>(st);
+    if (oven == OvenState::ERROR && target != OvenState::ERROR) {
+        up.reset(); lo.reset();
+        digitalWrite(Config::Pins::SAFETY_RELAY, HIGH);
+    }
+    if (target == OvenState::BAKING && !baking) startBake(curRecipe().bakeSec());
+    if (target != OvenState::BAKING && target != OvenState::BAKE_DONE) baking = false;
+    if (target == OvenState::ERROR) digitalWrite(Config::Pins::SAFETY_RELAY, LOW);
+    oven = target;
+}
+
+// 熱電対にフィルタ前の温度を与え、1制御周期（250ms×4回のloop）だけファームウェアを進める
+constexpr uint32_t CALL_MS = 250;
+
+void feed(float upRaw, float loRaw, float uh, float lh, int calls) {
+    host::State &s = host::state();
+    s.thermoC[Config::Pins::CS_UP_PLATE]  = upRaw;
+    s.thermoC[Config::Pins::CS_LO_PLATE]  = loRaw;
+    s.thermoC[Config::Pins::CS_UP_HEATER] = uh;
+    s.thermoC[Config::Pins::CS_LO_HEATER] = lh;
+    for (int i = 0; i < calls; i++) {
+        loop();
+        host::advance(CALL_MS);
+    }
+}
+
+Summary replay(const char *path) {
+    Summary sm = {};
+    LogReader log;
+    if (!log.open(path)) { perror(path); return sm; }
+
+    Settings st = defaultSettings();
+    if (opt.settingsPath) {
+        FILE *f = fopen(opt.settingsPath, "rb");
+        if (!f || fread(&st, sizeof(st), 1, f) != 1 || st.magic != Config::EEPROM_MAGIC) {
+            fprintf(stderr, "%s: not a settings image for this firmware\n", opt.settingsPath);
+            if (f) fclose(f);
+            return sm;
+        }
+        fclose(f);
+    }
+    uint8_t recipe = st.recipeIdx, limit = st.limitIdx;
+    if (opt.recipe < 0 || opt.limit < 0) detectSettings(log, recipe, limit);
+    if (opt.recipe >= 0) recipe = static_cast<uint8_t>(opt.recipe);
+    if (opt.limit >= 0) limit = static_cast<uint8_t>(opt.limit);
+    st.recipeIdx = (recipe < Config::RECIPE_CNT) ? recipe : 0;
+    st.limitIdx = (limit < Config::LIMIT_CNT) ? limit : 0;
+    sm.recipe = st.recipeIdx; sm.limit = st.limitIdx;
+
+    host::powerOn();
+    host::state().tcChip = Config::Thermo::CHIP;
+    EEPROM.put(0, st);
+    setup();
+
+    std::string out;
+    char buf[256];
+    const char *b, *e;
+    Record r;
+    float prevUp = 0, prevLo = 0;
+    int prevRecSt = -1, prevNewSt = -1;
+    unsigned shown = 0;
+    uint64_t idx = 0;
+    // テレメトリの UW/LW は代表ゾーンの出力のため、その定格で換算する
+    const float upW = Config::Zones::TABLE[Config::Zones::UP].ratedW / 255.0f / 3600.0f;
+    const float loW = Config::Zones::TABLE[Config::Zones::LO].ratedW / 255.0f / 3600.0f;
+
+    while (log.next(b, e)) {
+        sm.lines++;
+        if (!parseLine(b, e, r)) continue;
+        sm.records++;
+
+        // 運転中に変更された電力上限は、その記録の周期から反映する（--limit 指定時は固定）
+        int lm = limitOf(r);
+        if (opt.limit < 0 && lm >= 0 && lm != settings.limitIdx) {
+            if (sm.records > 1) sm.limitChanges++;
+            settings.limitIdx = static_cast<uint8_t>(lm);
+        }
+
+        // 起動直後のloopで最初の制御周期が走り（サンプル不足で出力0）、以降は4サンプルごとに来る。
+        // 記録の1行目をこの起動周期、2行目を最初の有効な周期に対応させる
+        // plateC(n) = 0.8*plateC(n-1) + 0.2*raw(n) の逆算。最初の有効な周期はファームウェアも記録値をそのまま採用する
+        float upRaw = (idx < 2) ? r.v[F_UP] : (r.v[F_UP] - 0.8f * prevUp) / 0.2f;
+        float loRaw = (idx < 2) ? r.v[F_LP] : (r.v[F_LP] - 0.8f * prevLo) / 0.2f;
+        if (Config::Thermo::CHIP != Config::Thermo::MAX31856) { // MAX6675/31855の0.25℃刻みに戻す（印字の丸め誤差を除去）
+            upRaw = roundf(upRaw * 4.0f) / 4.0f; loRaw = roundf(loRaw * 4.0f) / 4.0f;
+        }
+        if (isnan(r.v[F_UP])) upRaw = NAN;
+        if (isnan(r.v[F_LP])) loRaw = NAN;
+        feed(upRaw, loRaw, r.v[F_UH], r.v[F_LH], (idx == 0) ? 1 : 4);
+        if (!isnan(r.v[F_UP])) prevUp = r.v[F_UP];
+        if (!isnan(r.v[F_LP])) prevLo = r.v[F_LP];
+        idx++;
+
+        int recUw = static_cast<int>(r.v[F_UW]), recLw = static_cast<int>(r.v[F_LW]), recSt = static_cast<int>(r.v[F_ST]);
+        int newSt = static_cast<int>(oven);
+        int dUp = targetUpPWM - recUw, dLo = targetLoPWM - recLw;
+        int aUp = dUp < 0 ? -dUp : dUp, aLo = dLo < 0 ? -dLo : dLo;
+        sm.absUp += aUp; sm.absLo += aLo;
+        if (aUp > sm.maxUp) sm.maxUp = aUp;
+        if (aLo > sm.maxLo) sm.maxLo = aLo;
+        if (aUp > opt.tol) sm.pwmDiffUp++;
+        if (aLo > opt.tol) sm.pwmDiffLo++;
+        sm.recUpWh += recUw * upW; sm.recLoWh += recLw * loW;
+        sm.newUpWh += targetUpPWM * upW; sm.newLoWh += targetLoPWM * loW;
+        if (prevRecSt >= 0 && recSt != prevRecSt) sm.recTransitions++;
+        if (prevNewSt >= 0 && newSt != prevNewSt) sm.newTransitions++;
+
+        bool stDiff = (newSt != recSt);
+        if (stDiff) sm.stateDiffS++;
+        if ((stDiff || aUp > opt.tol || aLo > opt.tol) && shown < opt.maxDiffs) {
+            shown++;
+            snprintf(buf, sizeof(buf), "  L%-8llu ST %-9s %-9s UW %3d %3d  LW %3d %3d\n",
+                     static_cast<unsigned long long>(log.lineNo), stateName(recSt), stateName(newSt),
+                     recUw, targetUpPWM, recLw, targetLoPWM);
+            out += buf;
+        }
+        if (stDiff && !opt.free) syncState(recSt);
+        prevRecSt = recSt; prevNewSt = static_cast<int>(oven);
+    }
+
+    sm.ok = true;
+    double n = sm.records ? static_cast<double>(sm.records) : 1.0;
+    RecipeRef rr{ sm.recipe };
+    Config::Limit lim; memcpy_P(&lim, &Config::limits[sm.limit], sizeof(lim));
+    snprintf(buf, sizeof(buf), "%s: %llu lines, %llu records, %.1f MB  recipe %s  limit %.0fW\n", path,
+             static_cast<unsigned long long>(sm.lines), static_cast<unsigned long long>(sm.records),
+             log.bytes() / 1e6, rr.name() ? reinterpret_cast<const char *>(rr.name()) : "?", lim.watts);
+    std::string head = buf;
+    head += "  ---------  ST(rec)   ST(new)   UW(rec/new) LW(rec/new)\n";
+    out = head + out;
+    snprintf(buf, sizeof(buf), "  PWM up: %llu diff (%.1f%%) mean|d| %.2f max %d   lo: %llu diff (%.1f%%) mean|d| %.2f max %d\n",
+             static_cast<unsigned long long>(sm.pwmDiffUp), 100.0 * sm.pwmDiffUp / n, sm.absUp / n, sm.maxUp,
+             static_cast<unsigned long long>(sm.pwmDiffLo), 100.0 * sm.pwmDiffLo / n, sm.absLo / n, sm.maxLo);
+    out += buf;
+    snprintf(buf, sizeof(buf), "  energy up: %.1f -> %.1f Wh   lo: %.1f -> %.1f Wh\n", sm.recUpWh, sm.newUpWh, sm.recLoWh, sm.newLoWh);
+    out += buf;
+    if (sm.limitChanges) {
+        snprintf(buf, sizeof(buf), "  limit: %llu changes followed from LM\n", static_cast<unsigned long long>(sm.limitChanges));
+        out += buf;
+    }
+    snprintf(buf, sizeof(buf), "  state: %llu s differ, transitions %llu (rec) / %llu (new)%s\n",
+             static_cast<unsigned long long>(sm.stateDiffS), static_cast<unsigned long long>(sm.recTransitions),
+             static_cast<unsigned long long>(sm.newTransitions), opt.free ? "" : " [synced to rec]");
+    out += buf;
+    // 並列実行時に他ファイルの出力と混ざらないよう一括で書く
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+    return sm;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: replay [options] LOG...\n"
+        "  --settings FILE    EEPROM image (.bin from optimize) instead of defaults\n"
+        "  --recipe N         recipe index (default: detect from US/LS)\n"
+        "  --limit N          fixed power limit index (default: follow LM of each record)\n"
+        "  --tol N            PWM difference to ignore (default 0)\n"
+        "  --max-diffs N      differing seconds to list per log (default 20)\n"
+        "  --free             do not re-sync to the recorded state after a mismatch\n"
+        "  --jobs N           logs replayed in parallel (default: online CPUs)\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned jobs = sim::cpuCount();
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--free")) { opt.free = true; continue; }
+        if (a[0] != '-') { files.push_back(a); continue; }
+        if (!v) { usage(); return 2; }
+        if (!strcmp(a, "--settings")) opt.settingsPath = v;
+        else if (!strcmp(a, "--recipe")) opt.recipe = atoi(v);
+        else if (!strcmp(a, "--limit")) opt.limit = atoi(v);
+        else if (!strcmp(a, "--tol")) opt.tol = atoi(v);
+        else if (!strcmp(a, "--max-diffs")) opt.maxDiffs = static_cast<unsigned>(atoi(v));
+        else if (!strcmp(a, "--jobs")) jobs = static_cast<unsigned>(atoi(v));
+        else { usage(); return 2; }
+        i++;
+    }
+    if (files.empty()) { usage(); return 2; }
+
+    // ファームウェアの状態はプロセスに1台分のため、ログごとにプロセスを分ける
+    std::vector<Summary> res = sim::pool<Summary>(files.size(), jobs, [&](size_t k) { return replay(files[k]); });
+    int failed = 0;
+    for (const Summary &s : res) if (!s.ok) failed++;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,409 @@
+/*********************************************************************
+ * El-Pico v4 ホストシミュレーター
+ * ---------------------------------------------------------------
+ * ファームウェア(main.cpp)をそのまま取り込み、仮想時計と熱プラント
+ * モデルの上で実行する。最適化・ベンチマーク等のホストツールの共通基盤。
+ *
+ * [プラントモデル] ゾーンごとに ヒーター素線 → 蓄熱体 → 表面 の3ノード
+ *   熱電対は表面温度を測る（ピザ投入時の急な温度降下を再現するため）
+ * [ピザ] 下面は表面との接触伝導、上面は天井からの放射で加熱
+ *   100℃で水分が蒸発しきるまで温度が頭打ちになる
+ * [電流センサー] 主電源電流を RMS-DC変換の一次遅れ・ゲイン誤差・ノイズ付きで
+ *   Pins::MAINS_CT のADC値として与える（Config::Mains::SENSOR時にファームウェアが読む）
+ * [ハードウェア故障] SSRの短絡（ssrLeak）、素線の断線（drift=0）、熱電対の脱落（detached）
+ *********************************************************************/
+#pragma once
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+#include <functional>
+
+#include "../main.cpp"
+
+namespace sim {
+
+/* ================= PLANT ================= */
+struct ZonePlant {
+    float ratedW;
+    float cHeater, cBulk, cSurf;  // 熱容量 [J/K]
+    float gHB, gBS, gSA, gHA;     // 熱コンダクタンス [W/K]（素線-蓄熱体, 蓄熱体-表面, 表面-外気, 素線-外気）
+    float heaterC, bulkC, surfC;
+    float drift = 1.0f;           // 定格に対する実際の抵抗値の逆数（素線の経年劣化・個体差、電力比、0で断線）
+    float ssrLeak = 0.0f;         // SSRの短絡（指令OFF中も導通する割合、1で完全短絡。安全リレーでは遮断される）
+    uint8_t detached = 0;         // 熱電対の脱落（bit0:表面 bit1:素線）。脱落すると庫内の空気温度へ向かう
+    float tcSurfC = 25.0f, tcHeaterC = 25.0f; // 熱電対の先端の温度
+
+    void reset(float c) { heaterC = bulkC = surfC = tcSurfC = tcHeaterC = c; }
+};
+
+struct Pizza {
+    bool  in;
+    float c;          // 生地温度
+    float waterJ;     // 残りの蒸発潜熱
+    float absorbedJ;  // 吸収した熱量（焼き加減の指標）
+};
+
+class Plant {
+public:
+    ZonePlant up = { 850.0f, 120.0f,  400.0f, 150.0f, 5.0f, 30.0f, 1.0f, 0.2f,  25.0f, 25.0f, 25.0f };
+    ZonePlant lo = { 570.0f, 100.0f,  550.0f, 120.0f, 4.0f, 40.0f, 0.6f, 0.15f, 25.0f, 25.0f, 25.0f };
+    float ambientC = 25.0f;
+    float gUL = 0.3f;                 // 上下表面間の放射・対流 [W/K]
+    float pizzaCap = 500.0f;          // ピザの熱容量 [J/K]
+    float pizzaContact = 4.0f;        // 下面の接触伝導 [W/K]
+    float pizzaRad = 1.2e-9f;         // 上面の放射係数 σεA×形態係数 [W/K^4]
+    float pizzaWaterJ = 70000.0f;     // 蒸発する水分の潜熱 [J]
+    float mainsScale = 1.0f;          // 電源電圧変動（電力比）
+    float nominalV = Config::Mains::VOLTS;
+    float otherA = 0.15f;             // ヒーター以外の消費電流（制御回路・ファン）
+    Pizza pizza = {};
+
+    // センサー
+    float noiseC = 0.3f;              // 読み取りノイズの標準偏差
+    float nanProb = 0.0f;             // 1読み取りあたりの欠損確率（ノイズバースト用）
+    float ctGain = 1.0f;              // 電流センサーのゲイン（1で正確）
+    float ctNoiseA = 0.05f;           // 電流センサーのノイズの標準偏差 [A]
+    float ctTauS = 0.03f;             // RMS-DC変換の時定数 [s]
+    float ctA = 0.0f;                 // 電流センサーの出力（一次遅れの状態）
+    float detachTauS = 20.0f;         // 脱落した熱電対が空気温度に馴染む時定数 [s]
+
+    void reset() {
+        up.reset(ambientC); lo.reset(ambientC);
+        pizza = Pizza();
+        ctA = 0.0f;
+    }
+
+    void load(float doughC = 8.0f) { pizza.in = true; pizza.c = doughC; pizza.waterJ = pizzaWaterJ; pizza.absorbedJ = 0; }
+    float unload() { pizza.in = false; return pizza.absorbedJ; }
+
+    void step(float dt, float upDuty, float loDuty) {
+        float qPizzaLo = 0, qPizzaUp = 0;
+        if (pizza.in) {
+            float tp = pizza.c + 273.15f, tu = up.surfC + 273.15f;
+            qPizzaLo = pizzaContact * (lo.surfC - pizza.c);
+            qPizzaUp = pizzaRad * (tu * tu * tu * tu - tp * tp * tp * tp);
+            float q = (qPizzaLo + qPizzaUp) * dt;
+            pizza.absorbedJ += q;
+            if (pizza.c >= 100.0f && pizza.waterJ > 0) {
+                pizza.waterJ -= q; // 蒸発中は温度一定
+            } else {
+                pizza.c += q / pizzaCap;
+            }
+        }
+        float qUL = gUL * (up.surfC - lo.surfC);
+        zone(up, dt, upDuty, qPizzaUp + qUL);
+        zone(lo, dt, loDuty, qPizzaLo - qUL);
+        float airC = ambientC + 0.6f * ((up.surfC + lo.surfC) * 0.5f - ambientC);
+        probe(up, dt, airC);
+        probe(lo, dt, airC);
+    }
+
+    // 主電源の実電流 [A]（抵抗負荷: 電流は電圧に比例し、電力は電圧の2乗に比例）
+    float mainsA(float upDuty, float loDuty) const {
+        float v = nominalV * sqrtf(mainsScale);
+        return otherA + (up.ratedW * up.drift * upDuty + lo.ratedW * lo.drift * loDuty) * mainsScale / v;
+    }
+
+    // 電流センサーのADC値
+    uint16_t readCt(float dt, float upDuty, float loDuty) {
+        ctA += (mainsA(upDuty, loDuty) - ctA) * (1.0f - expf(-dt / ctTauS));
+        float lsb = (ctA * ctGain + gauss() * ctNoiseA) / Config::Mains::A_PER_LSB + 0.5f;
+        return static_cast<uint16_t>(constrain(lsb, 0.0f, 1023.0f));
+    }
+
+    // 熱電対の読み値（ノイズ付き、欠損時NaN）
+    float read(float c) {
+        if (nanProb > 0.0f && uniform() < nanProb) return NAN;
+        return c + gauss() * noiseC;
+    }
+
+    void seed(uint32_t s) { _rng = s ? s : 1; }
+    float uniform() { _rng ^= _rng << 13; _rng ^= _rng >> 17; _rng ^= _rng << 5; return (_rng & 0xFFFFFF) / 16777216.0f; }
+    float gauss() { float s = 0; for (int i = 0; i < 4; i++) s += uniform(); return (s - 2.0f) * 1.7320508f; }
+
+private:
+    // 熱電対の先端（接触していれば測定対象と同じ温度）
+    void probe(ZonePlant &z, float dt, float airC) {
+        float k = 1.0f - expf(-dt / detachTauS);
+        z.tcSurfC   = (z.detached & 1) ? z.tcSurfC + (airC - z.tcSurfC) * k : z.surfC;
+        z.tcHeaterC = (z.detached & 2) ? z.tcHeaterC + (airC - z.tcHeaterC) * k : z.heaterC;
+    }
+
+    void zone(ZonePlant &z, float dt, float duty, float qOutSurf) {
+        float p = z.ratedW * z.drift * mainsScale * duty;
+        float qHB = z.gHB * (z.heaterC - z.bulkC);
+        float qBS = z.gBS * (z.bulkC - z.surfC);
+        z.heaterC += (p - qHB - z.gHA * (z.heaterC - ambientC)) / z.cHeater * dt;
+        z.bulkC   += (qHB - qBS) / z.cBulk * dt;
+        z.surfC   += (qBS - z.gSA * (z.surfC - ambientC) - qOutSurf) / z.cSurf * dt;
+    }
+
+    uint32_t _rng = 1;
+};
+
+/* ================= KPI ================= */
+struct Kpi {
+    double upWh = 0, loWh = 0;
+    float  peakHeaterC = 0;
+    float  overHeaterS = 0;        // HEATER_MAX_C を超えていた時間
+    float  overshootC = 0;         // READY到達後の表面温度の目標超過の最大値
+    bool   armed = false;          // READY到達後に超過量の計測を開始
+    // 取り出しからREADY復帰までの時間
+    uint32_t unloadMs = 0;
+    bool   recovering = false;
+    float  recoverSumS = 0, recoverMaxS = 0;
+    uint16_t recoverCnt = 0;
+};
+
+/* ================= RUNNER ================= */
+// ファームウェアを仮想時間で駆動する（プロセス内に1台のみ。並列実行はpool()でプロセスを分ける）
+class Runner {
+public:
+    Plant plant;
+    Kpi kpi;
+    uint32_t stepMs = 10;
+    std::function<void()> everySecond; // 1秒ごとの観測フック（ベンチマーク等で使用）
+    bool attended = false;             // 操作者が常駐（無操作タイムアウトによるエコ保温/休止を起こさない）
+
+    // 電源投入から setup() 完了まで。preset 指定時はEEPROMに書き込んでから起動
+    void boot(const Settings *preset = nullptr, uint32_t seed = 1) {
+        host::powerOn();
+        host::state().tcChip = Config::Thermo::CHIP;
+        plant.seed(seed);
+        plant.reset();
+        if (preset) EEPROM.put(0, *preset);
+        sense();
+        setup();
+        kpi = Kpi();
+    }
+
+    void step() {
+        host::State &s = host::state();
+        float dt = stepMs / 1000.0f;
+        float upDuty = s.pinOut[Config::Pins::SSR_UP] ? 1.0f : plant.up.ssrLeak;
+        float loDuty = s.pinOut[Config::Pins::SSR_LO] ? 1.0f : plant.lo.ssrLeak;
+        if (!s.pinOut[Config::Pins::SAFETY_RELAY]) upDuty = loDuty = 0.0f; // 安全リレー遮断
+        plant.step(dt, upDuty, loDuty);
+        kpi.upWh += plant.up.ratedW * plant.up.drift * plant.mainsScale * upDuty * dt / 3600.0;
+        kpi.loWh += plant.lo.ratedW * plant.lo.drift * plant.mainsScale * loDuty * dt / 3600.0;
+        if (Config::Mains::SENSOR) s.analog[Config::Pins::MAINS_CT] = plant.readCt(dt, upDuty, loDuty); // 無効時は乱数列を変えない
+        host::advance(stepMs);
+        if (millis() % IntelligentHeater::SAMPLE_MS < stepMs) sense(); // 熱電対アンプの読み出し周期ごとに新しい値
+        loop();
+        if (millis() % 1000 < stepMs) {
+            if (attended) lastActMs = millis();
+            observe();
+            if (everySecond) everySecond();
+        }
+    }
+
+    void run(uint32_t ms) { for (uint32_t t = 0; t < ms; t += stepMs) step(); }
+
+    // 条件が成立するまで実行（タイムアウトでfalse）
+    bool runUntil(const std::function<bool()> &cond, uint32_t timeoutMs) {
+        for (uint32_t t = 0; t < timeoutMs; t += stepMs) {
+            if (cond()) return true;
+            step();
+        }
+        return cond();
+    }
+
+    // [操作] エンコーダ1クリック（dir: +1/-1）
+    void turn(int dir) {
+        host::State &s = host::state();
+        s.pinIn[Config::Pins::ENC_DT] = (dir > 0) ? HIGH : LOW;
+        s.pinIn[Config::Pins::ENC_CLK] = LOW;
+        run(20);
+        s.pinIn[Config::Pins::ENC_CLK] = HIGH;
+        run(60);
+    }
+
+    // [操作] ボタン押下（holdMs: 押している時間）
+    void press(uint32_t holdMs = 200) {
+        host::State &s = host::state();
+        s.pinIn[Config::Pins::ENC_SW] = LOW;
+        run(holdMs);
+        s.pinIn[Config::Pins::ENC_SW] = HIGH;
+        run(100);
+    }
+
+    // 目標レシピ番号までエンコーダを回す
+    void selectRecipe(uint8_t idx) {
+        while (settings.recipeIdx != idx) turn(+1);
+    }
+
+    void sense() {
+        host::State &s = host::state();
+        s.thermoC[Config::Pins::CS_UP_PLATE]  = plant.read(plant.up.tcSurfC);
+        s.thermoC[Config::Pins::CS_UP_HEATER] = plant.read(plant.up.tcHeaterC);
+        s.thermoC[Config::Pins::CS_LO_PLATE]  = plant.read(plant.lo.tcSurfC);
+        s.thermoC[Config::Pins::CS_LO_HEATER] = plant.read(plant.lo.tcHeaterC);
+    }
+
+private:
+    void observe() {
+        float h = max(plant.up.heaterC, plant.lo.heaterC);
+        if (h > kpi.peakHeaterC) kpi.peakHeaterC = h;
+        if (h > Config::Hard::HEATER_MAX_C) kpi.overHeaterS += 1.0f;
+        if (oven == OvenState::READY) kpi.armed = true;
+        if (kpi.recovering && oven == OvenState::READY) {
+            float s = (millis() - kpi.unloadMs) / 1000.0f;
+            kpi.recovering = false;
+            kpi.recoverSumS += s; kpi.recoverCnt++;
+            if (s > kpi.recoverMaxS) kpi.recoverMaxS = s;
+        }
+        if (kpi.armed && (oven == OvenState::READY || oven == OvenState::PREHEAT ||
+                          oven == OvenState::BAKING || oven == OvenState::BAKE_DONE)) {
+            float upT, loT;
+            zoneTargets(upT, loT);
+            float o = max(plant.up.surfC - upT, plant.lo.surfC - loT);
+            if (o > kpi.overshootC) kpi.overshootC = o;
+        }
+    }
+};
+
+/* ================= SERVICE SCENARIO ================= */
+// コールドスタートから READY 到達後、一定間隔でピザを投入し続ける営業シナリオ
+struct ServiceResult {
+    float readyS;         // 起動からREADYまで
+    float pph;            // 枚/時（最初のREADYから最後の取り出しまで）
+    float whPerPizza;     // 1枚あたりの電力量（待機分を含む）
+    float overshootC;
+    float peakHeaterC;
+    float overHeaterS;
+    float doseCv;         // ピザ吸収熱量の変動係数（焼きムラ）
+    float meanDoseKJ;
+    float recoverS, recoverMaxS; // 取り出しからREADY復帰まで（平均/最大）
+    uint16_t baked, missed; // 焼成数 / 自動開始しなかった数
+    bool  ok;
+};
+
+// READYまで待つ。無操作でエコ保温に入った場合は操作者がボタンで再加熱させる
+inline bool waitReady(Runner &r, uint32_t timeoutMs) {
+    return r.runUntil([&r] {
+        if (oven == OvenState::ECO) r.press();
+        return oven == OvenState::READY;
+    }, timeoutMs);
+}
+
+inline ServiceResult runService(Runner &r, uint16_t pizzas, uint32_t intervalMs) {
+    ServiceResult res = {};
+    if (!waitReady(r, 2UL * 3600UL * 1000UL)) return res;
+    uint32_t t0 = millis();
+    res.readyS = t0 / 1000.0f;
+    double wh0 = r.kpi.upWh + r.kpi.loWh;
+    double sum = 0, sum2 = 0;
+
+    for (uint16_t k = 0; k < pizzas; k++) {
+        uint32_t arrival = t0 + k * intervalMs;
+        r.runUntil([&] { return millis() >= arrival; }, intervalMs + 1000UL);
+        if (!waitReady(r, 30UL * 60UL * 1000UL)) return res;
+        uint16_t nominal = curRecipe().bakeSec();
+        r.plant.load();
+        bool started = r.runUntil([] { return oven == OvenState::BAKING; }, 10000UL);
+        if (started) {
+            r.runUntil([] { return oven != OvenState::BAKING; }, nominal * 3000UL);
+        } else {
+            res.missed++;
+            r.run(nominal * 1000UL); // 手動でタイマーを測った場合相当
+        }
+        r.run(2000); // 取り出しまでの手間
+        double d = r.plant.unload() / 1000.0;
+        r.kpi.unloadMs = millis(); r.kpi.recovering = true;
+        sum += d; sum2 += d * d;
+        res.baked++;
+        if (oven == OvenState::ERROR) return res;
+    }
+    float span = (millis() - t0) / 1000.0f;
+    waitReady(r, 30UL * 60UL * 1000UL); // 最後の1枚の復帰時間を取る
+    res.recoverS = r.kpi.recoverCnt ? r.kpi.recoverSumS / r.kpi.recoverCnt : 0;
+    res.recoverMaxS = r.kpi.recoverMaxS;
+    res.pph = res.baked * 3600.0f / span;
+    res.whPerPizza = static_cast<float>((r.kpi.upWh + r.kpi.loWh - wh0) / res.baked);
+    res.meanDoseKJ = static_cast<float>(sum / res.baked);
+    double var = sum2 / res.baked - res.meanDoseKJ * res.meanDoseKJ;
+    res.doseCv = (res.meanDoseKJ > 0) ? static_cast<float>(sqrt(var > 0 ? var : 0) / res.meanDoseKJ) : 0;
+    res.overshootC = r.kpi.overshootC;
+    res.peakHeaterC = r.kpi.peakHeaterC;
+    res.overHeaterS = r.kpi.overHeaterS;
+    res.ok = true;
+    return res;
+}
+
+/* ================= PROCESS POOL ================= */
+// ファームウェアの状態はグローバル/関数内staticのため、1ジョブ=1プロセスで分離して並列実行する
+// fn はフォークした子プロセス内で呼ばれ、POD の結果をパイプで親に返す
+template <class Result>
+std::vector<Result> pool(size_t jobs, unsigned workers, const std::function<Result(size_t)> &fn,
+                         const std::function<void(size_t, const Result &)> &onDone = nullptr) {
+    struct Slot { pid_t pid; int fd; size_t job; };
+    std::vector<Result> out(jobs);
+    std::vector<Slot> running;
+    size_t next = 0;
+    if (workers == 0) workers = 1;
+
+    auto reap = [&](size_t i) {
+        Slot sl = running[i];
+        Result r = {};
+        size_t got = 0;
+        while (got < sizeof(Result)) {
+            ssize_t n = read(sl.fd, reinterpret_cast<char *>(&r) + got, sizeof(Result) - got);
+            if (n <= 0) break;
+            got += static_cast<size_t>(n);
+        }
+        close(sl.fd);
+        waitpid(sl.pid, nullptr, 0);
+        out[sl.job] = r;
+        if (onDone) onDone(sl.job, r);
+        running.erase(running.begin() + static_cast<long>(i));
+    };
+
+    while (next < jobs || !running.empty()) {
+        while (next < jobs && running.size() < workers) {
+            int fds[2];
+            if (pipe(fds) != 0) { perror("pipe"); exit(1); }
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) { perror("fork"); exit(1); }
+            if (pid == 0) {
+                close(fds[0]);
+                Result r = fn(next);
+                const char *p = reinterpret_cast<const char *>(&r);
+                size_t left = sizeof(Result);
+                while (left) { ssize_t n = write(fds[1], p, left); if (n <= 0) break; p += n; left -= static_cast<size_t>(n); }
+                _exit(0);
+            }
+            close(fds[1]);
+            running.push_back({ pid, fds[0], next++ });
+        }
+        // 先頭から順に回収（子は結果を書いたら即終了するため、readは長く待たない）
+        reap(0);
+    }
+    return out;
+}
+
+inline unsigned cpuCount() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? static_cast<unsigned>(n) : 1;
+}
+
+// avrdude -U eeprom:w:<file>:i で書き込めるIntel HEX形式で出力
+inline bool writeIntelHex(const char *path, const void *data, size_t len, uint16_t addr = 0) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    for (size_t off = 0; off < len; off += 16) {
+        uint8_t n = static_cast<uint8_t>((len - off < 16) ? len - off : 16);
+        uint16_t a = static_cast<uint16_t>(addr + off);
+        uint8_t sum = static_cast<uint8_t>(n + (a >> 8) + (a & 0xFF));
+        fprintf(f, ":%02X%04X00", n, a);
+        for (uint8_t i = 0; i < n; i++) { fprintf(f, "%02X", p[off + i]); sum = static_cast<uint8_t>(sum + p[off + i]); }
+        fprintf(f, "%02X\n", static_cast<uint8_t>(-sum));
+    }
+    fprintf(f, ":00000001FF\n");
+    return fclose(f) == 0;
+}
+
+} // namespace sim
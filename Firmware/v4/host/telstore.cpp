@@ -0,0 +1,1133 @@
+/*********************************************************************
+ * El-Pico v4 テレメトリ・ストア（ホスト用）
+ * ---------------------------------------------------------------
+ * debugTelemetry のシリアル出力を複数台ぶん取り込み、列指向・追記専用のストアに
+ * 蓄積する。1分・1時間のロールアップを取り込み時に作るので、数か月分の傾向も
+ * ロールアップを読むだけで即座に答えられる。
+ *
+ * [取り込み] ingest はシリアルポート（115200bps、抜けたら再接続）か、実機の代わりの
+ *   ログファイルを読む。ログに時刻は無いため、ポートは受信時刻、ファイルは --start から
+ *   1行1秒で時刻を振る（既定はファイルの更新時刻で終わるように逆算）
+ * [保存] DIR/<炉>/raw/YYYY-MM-DD.seg … 1日1セグメント。1時間以内のブロックを追記し、
+ *   ブロック内は項目ごとの列に分けて固定小数(×100)の差分をzigzag+varintで詰める
+ *   （温度はほぼ毎秒同じなので1項目1バイト前後）。問い合わせは必要な列だけを展開する
+ *   DIR/<炉>/1m/YYYY-MM.seg … 1分ごとの項目別 count/min/max/sum。生データと同じ列ブロックに
+ *   差分で詰める（動かない項目はほぼ0バイト）。DIR/<炉>/1h.r … 1時間ごとの min/max/avg/count（固定長）
+ * [再開] ストアの最終時刻以前の行は捨てるので、同じログを再投入しても重複しない。
+ *   止めた時点の集計は部分バケットとして書き、問い合わせ時に同じ時刻どうしを合算する
+ * [問い合わせ] --step が1時間の倍数なら1h、1分の倍数なら1m、それ以外は生データを読む。
+ *   範囲は step の境界（UTC）に丸める。runs はST列から状態の所要時間（既定: 予熱→READY）を出す。
+ *   記録の途中から始まった区間は数えないが、起動直後（EU+ELがほぼ0）の行から始まる起動時の予熱は数える
+ *
+ * ビルド: g++ -std=c++17 -O2 -o telstore Firmware/v4/host/telstore.cpp
+ *
+ * 例:
+ *   ./telstore ingest store --oven 1=/dev/ttyACM0 --oven 2=/dev/ttyACM1
+ *   ./telstore ingest store --oven 2=day1.txt --start 2026-07-01T08:00
+ *   ./telstore query store --oven 2 --field UP,LP --from -90d --step 1d --agg max
+ *   ./telstore runs store --oven 2 --from -90d --step 7d
+ *   ./telstore info store
+ *********************************************************************/
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* ================= FIELDS ================= */
+// 列番号としてファイルに残るので、追加は末尾にのみ行う
+enum Field : uint8_t {
+    F_US, F_LS, F_UP, F_LP, F_UH, F_LH, F_UW, F_LW, F_SK, F_ST, F_RJ, F_MF, F_HU, F_SD, F_EU, F_EL,
+    F_WP, F_DR, F_RC, F_PH, F_PZ, F_DW, F_TF, F_EC, F_RB, F_RU, F_RL, F_LU, F_LL, F_LB, F_MA, F_WU,
+    F_WL, F_LM, FIELD_CNT
+};
+const char FIELD_KEYS[FIELD_CNT][3] = {
+    "US", "LS", "UP", "LP", "UH", "LH", "UW", "LW", "SK", "ST", "RJ", "MF", "HU", "SD", "EU", "EL",
+    "WP", "DR", "RC", "PH", "PZ", "DW", "TF", "EC", "RB", "RU", "RL", "LU", "LL", "LB", "MA", "WU",
+    "WL", "LM"
+};
+// ST と行末の LM が揃った行だけを取る（接続直後の途中行を捨てる）
+constexpr uint64_t REQUIRED = (1ULL << F_ST) | (1ULL << F_LM);
+
+const char *const STATE_NAMES[] = {
+    "IDLE", "PREHEAT", "READY", "BAKING", "BAKE_DONE", "REST", "COOLING", "SHUTDOWN", "ERROR", "TUNING", "ECO", "PLANNED"
+};
+constexpr int STATE_CNT = sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]);
+
+int8_t fieldOf(char a, char b) {
+    static int8_t table[26 * 26];
+    static bool init = false;
+    if (!init) {
+        memset(table, -1, sizeof(table));
+        for (int f = 0; f < FIELD_CNT; f++) table[(FIELD_KEYS[f][0] - 'A') * 26 + (FIELD_KEYS[f][1] - 'A')] = static_cast<int8_t>(f);
+        init = true;
+    }
+    return table[(a - 'A') * 26 + (b - 'A')];
+}
+
+int fieldByName(const char *s) {
+    if (strlen(s) != 2 || s[0] < 'A' || s[0] > 'Z' || s[1] < 'A' || s[1] > 'Z') return -1;
+    return fieldOf(s[0], s[1]);
+}
+
+int stateByName(const char *s) {
+    for (int i = 0; i < STATE_CNT; i++) if (!strcasecmp(s, STATE_NAMES[i])) return i;
+    char *e;
+    long v = strtol(s, &e, 10);
+    return (*s && !*e && v >= 0 && v < STATE_CNT) ? static_cast<int>(v) : -1;
+}
+
+/* ================= PARSER ================= */
+struct Rec {
+    uint32_t t;              // UNIX秒（UTC）
+    uint64_t mask;           // 取得できた項目
+    int64_t v[FIELD_CNT];    // 値×100
+};
+
+// Serial.print(float) の出力（小数2桁）を固定小数×100で読む。"nan"/"inf"/"ovf" は欠測
+// 戻り値: 0=数値でない, 1=値あり, 2=欠測。0以外はpを進める
+int parseFixed(const char *&p, const char *end, int64_t &out) {
+    const char *s = p;
+    bool neg = false;
+    if (s < end && *s == '-') { neg = true; s++; }
+    if (s + 3 <= end && (!memcmp(s, "nan", 3) || !memcmp(s, "inf", 3) || !memcmp(s, "ovf", 3))) { p = s + 3; return 2; }
+    int64_t ip = 0; int fp = 0, digits = 0; bool any = false, up = false;
+    while (s < end && *s >= '0' && *s <= '9') { if (ip < 1000000000000LL) ip = ip * 10 + (*s - '0'); s++; any = true; }
+    if (s < end && *s == '.') {
+        s++;
+        while (s < end && *s >= '0' && *s <= '9') {
+            if (digits < 2) fp = fp * 10 + (*s - '0');
+            else if (digits == 2) up = *s >= '5';
+            digits++; s++; any = true;
+        }
+    }
+    if (!any) return 0;
+    while (digits < 2) { fp *= 10; digits++; }
+    int64_t v = ip * 100 + fp + (up ? 1 : 0);
+    out = neg ? -v : v;
+    p = s;
+    return 1;
+}
+
+// 1行を解析。タイムスタンプ等の前置きや未知の項目、MA の故障印 '!' は読み飛ばす
+bool parseLine(const char *p, const char *end, Rec &r) {
+    r.mask = 0;
+    uint64_t seen = 0;
+    while (p + 3 <= end) {
+        if (p[2] == ':' && p[0] >= 'A' && p[0] <= 'Z' && p[1] >= 'A' && p[1] <= 'Z') {
+            int8_t f = fieldOf(p[0], p[1]);
+            const char *q = p + 3;
+            int64_t v;
+            int k = f >= 0 ? parseFixed(q, end, v) : 0;
+            if (k) {
+                seen |= 1ULL << f;
+                if (k == 1) { r.v[f] = v; r.mask |= 1ULL << f; }
+                p = q;
+                continue;
+            }
+            p += 3;
+        } else {
+            p++;
+        }
+    }
+    return (seen & REQUIRED) == REQUIRED;
+}
+
+/* ================= ENCODING ================= */
+inline void putVar(std::string &o, uint64_t v) {
+    while (v >= 0x80) { o += static_cast<char>(v | 0x80); v >>= 7; }
+    o += static_cast<char>(v);
+}
+inline bool getVar(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for (int sh = 0; p < end && sh < 64; sh += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << sh;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+inline uint64_t zz(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t unzz(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// 値の並びを前の値との差分zigzag varintで書く。差分0の後には続く0の個数を置くので、
+// 設定値・状態・積算値のように動かない列や、1秒刻みの時刻の差分はほぼ0バイトになる
+class DeltaWriter {
+public:
+    explicit DeltaWriter(std::string &o) : _o(o) {}
+    void put(int64_t v) {
+        int64_t d = v - _prev;
+        _prev = v;
+        if (_zeros && d == 0) { _zeros++; return; }
+        if (_zeros) { putVar(_o, _zeros - 1); _zeros = 0; }
+        putVar(_o, zz(d));
+        if (d == 0) _zeros = 1;
+    }
+    void finish() { if (_zeros) putVar(_o, _zeros - 1); _zeros = 0; }
+
+private:
+    std::string &_o;
+    int64_t _prev = 0;
+    uint64_t _zeros = 0;
+};
+
+class DeltaReader {
+public:
+    DeltaReader(const uint8_t *p, const uint8_t *end) : _p(p), _end(end) {}
+    bool next(int64_t &v) {
+        if (_same) { _same--; v = _prev; return true; }
+        uint64_t d;
+        if (!getVar(_p, _end, d) || (d == 0 && !getVar(_p, _end, _same))) return false;
+        _prev += unzz(d);
+        v = _prev;
+        return true;
+    }
+    // 直前の値がこの後そのまま続く個数。skip で読み飛ばせる（変化点だけを追う走査用）
+    uint64_t repeats() const { return _same; }
+    void skip() { _same = 0; }
+    // 読んだ所の直後。書いた個数を読み終えれば続けて書いた次の列の先頭になる
+    const uint8_t *pos() const { return _p; }
+
+private:
+    const uint8_t *_p, *_end;
+    int64_t _prev = 0;
+    uint64_t _same = 0;
+};
+
+// セグメント内のブロック。見出しの後に列の長さ表（時刻列＋mask の各項目）と列本体が続く
+//   時刻列: 2件目以降の時刻差を DeltaWriter で（つまり差分の差分）
+//   項目列: 0=全件あり / 1=有無ビットマップ付き、の1バイトの後、ある値だけを DeltaWriter で
+constexpr uint32_t BLOCK_MAGIC = 0x31425354; // "TSB1"
+constexpr uint32_t ROLL_BLOCK_MAGIC = 0x314D5354; // "TSM1" 1分ロールアップ（列の並びは ROLLUP を参照）
+constexpr size_t BLOCK_MAX = 3600;
+struct BlockHead {
+    uint32_t magic, t0, t1, n;
+    uint64_t mask;
+    uint32_t bytes, reserved;  // bytes: 見出しより後ろのバイト数
+};
+static_assert(sizeof(BlockHead) == 32, "on-disk layout");
+
+// 項目の列より前にある列の数（生データ: 時刻、1分ロールアップ: 時刻と行数）
+inline size_t leadCols(const BlockHead &h) { return h.magic == ROLL_BLOCK_MAGIC ? 2 : 1; }
+
+// 見出しと列の長さ表を付けて1ブロックにする
+std::string packBlock(uint32_t magic, uint32_t t0, uint32_t t1, uint32_t n, uint64_t mask, const std::vector<std::string> &cols) {
+    BlockHead h{ magic, t0, t1, n, mask, 0, 0 };
+    std::string body;
+    for (const std::string &c : cols) { uint32_t len = static_cast<uint32_t>(c.size()); body.append(reinterpret_cast<const char *>(&len), 4); }
+    for (const std::string &c : cols) body += c;
+    h.bytes = static_cast<uint32_t>(body.size());
+    return std::string(reinterpret_cast<const char *>(&h), sizeof(h)) + body;
+}
+
+std::string encodeBlock(const std::vector<Rec> &rs) {
+    uint64_t mask = 0;
+    for (const Rec &r : rs) mask |= r.mask;
+    std::vector<std::string> cols(1);
+    DeltaWriter tw(cols[0]);
+    for (size_t i = 1; i < rs.size(); i++) tw.put(rs[i].t - rs[i - 1].t);
+    tw.finish();
+    for (int f = 0; f < FIELD_CNT; f++) {
+        if (!(mask >> f & 1)) continue;
+        cols.emplace_back();
+        std::string &c = cols.back();
+        bool all = true;
+        for (const Rec &r : rs) if (!(r.mask >> f & 1)) { all = false; break; }
+        c += static_cast<char>(all ? 0 : 1);
+        if (!all) {
+            size_t at = c.size();
+            c.resize(at + (rs.size() + 7) / 8);
+            for (size_t i = 0; i < rs.size(); i++) if (rs[i].mask >> f & 1) c[at + i / 8] |= static_cast<char>(1 << (i % 8));
+        }
+        DeltaWriter w(c);
+        for (const Rec &r : rs) if (r.mask >> f & 1) w.put(r.v[f]);
+        w.finish();
+    }
+    return packBlock(BLOCK_MAGIC, rs.front().t, rs.back().t, static_cast<uint32_t>(rs.size()), mask, cols);
+}
+
+/* ================= ROLLUP ================= */
+// 1時間は固定長レコード。1項目16バイトなので、1項目の問い合わせは1レコード1キャッシュラインで済む
+struct Agg { float mn, mx, avg; uint32_t cnt; };
+struct Roll { uint32_t t, n; Agg a[FIELD_CNT]; };
+struct RollHead { uint32_t magic, recSize, step, reserved; };
+constexpr uint32_t ROLL_MAGIC = 0x31525354; // "TSR1"
+
+// 取り込み中の集計（値×100のまま持つ）
+struct RollAcc {
+    uint32_t t = 0, n = 0;
+    int64_t sum[FIELD_CNT], mn[FIELD_CNT], mx[FIELD_CNT];
+    uint32_t cnt[FIELD_CNT];
+
+    void start(uint32_t bucket) { t = bucket; n = 0; memset(cnt, 0, sizeof(cnt)); memset(sum, 0, sizeof(sum)); }
+    void add(const Rec &r) {
+        n++;
+        for (int f = 0; f < FIELD_CNT; f++) {
+            if (!(r.mask >> f & 1)) continue;
+            int64_t v = r.v[f];
+            if (!cnt[f]++) { mn[f] = mx[f] = v; } else { mn[f] = std::min(mn[f], v); mx[f] = std::max(mx[f], v); }
+            sum[f] += v;
+        }
+    }
+    Roll out() const {
+        Roll r;
+        memset(&r, 0, sizeof(r));
+        r.t = t; r.n = n;
+        for (int f = 0; f < FIELD_CNT; f++) {
+            if (!cnt[f]) continue;
+            r.a[f] = Agg{ mn[f] / 100.0f, mx[f] / 100.0f, static_cast<float>(sum[f] / 100.0 / cnt[f]), cnt[f] };
+        }
+        return r;
+    }
+};
+
+// 1分ロールアップのブロック（見出しと長さ表は生データと同じ）。固定長だと1分552バイト、
+// 1日795kBで生データより大きくなるため、列に分けて差分で詰める
+//   列0: 時刻（生データと同じ）、列1: 各分の行数
+//   項目列: 各分の件数を DeltaWriter で、続けて件数のある分だけの最小・最大・合計（×100）を
+//   それぞれ DeltaWriter で書く
+std::string encodeRollBlock(const std::vector<RollAcc> &ms) {
+    uint64_t mask = 0;
+    for (const RollAcc &m : ms) for (int f = 0; f < FIELD_CNT; f++) if (m.cnt[f]) mask |= 1ULL << f;
+    std::vector<std::string> cols(2);
+    DeltaWriter tw(cols[0]), nw(cols[1]);
+    for (size_t i = 1; i < ms.size(); i++) tw.put(ms[i].t - ms[i - 1].t);
+    for (const RollAcc &m : ms) nw.put(m.n);
+    tw.finish(); nw.finish();
+    for (int f = 0; f < FIELD_CNT; f++) {
+        if (!(mask >> f & 1)) continue;
+        cols.emplace_back();
+        std::string &c = cols.back();
+        { DeltaWriter w(c); for (const RollAcc &m : ms) w.put(m.cnt[f]); w.finish(); }
+        using Stat = int64_t (RollAcc::*)[FIELD_CNT];
+        for (Stat a : { &RollAcc::mn, &RollAcc::mx, &RollAcc::sum }) {
+            DeltaWriter w(c);
+            for (const RollAcc &m : ms) if (m.cnt[f]) w.put((m.*a)[f]);
+            w.finish();
+        }
+    }
+    return packBlock(ROLL_BLOCK_MAGIC, ms.front().t, ms.back().t, static_cast<uint32_t>(ms.size()), mask, cols);
+}
+
+/* ================= FILES ================= */
+std::string dayName(uint32_t t) {
+    time_t tt = t; struct tm tm; gmtime_r(&tt, &tm);
+    char b[40]; snprintf(b, sizeof(b), "%04d-%02d-%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    return b;
+}
+std::string monthName(uint32_t t) { return dayName(t).substr(0, 7); }
+std::string isoTime(int64_t t) {
+    time_t tt = static_cast<time_t>(t); struct tm tm; gmtime_r(&tt, &tm);
+    char b[32]; strftime(b, sizeof(b), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return b;
+}
+
+bool mkdirs(const std::string &path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i < path.size() && path[i] != '/') continue;
+        std::string d = path.substr(0, i);
+        if (mkdir(d.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+    return true;
+}
+
+// 1回のwriteで追記する（落ちても壊れるのは末尾の1件だけで、読む側が捨てる）。新規ファイルには先にhdrを書く
+bool appendTo(const std::string &path, const std::string &data, const std::string &hdr = std::string()) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        size_t slash = path.rfind('/');
+        if (slash == std::string::npos || !mkdirs(path.substr(0, slash))) return false;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) return false;
+    }
+    struct stat st;
+    std::string buf = (fstat(fd, &st) == 0 && st.st_size == 0) ? hdr + data : data;
+    bool ok = write(fd, buf.data(), buf.size()) == static_cast<ssize_t>(buf.size());
+    close(fd);
+    return ok;
+}
+
+std::vector<std::string> listDir(const std::string &dir, const char *suffix) {
+    std::vector<std::string> out;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return out;
+    size_t sl = strlen(suffix);
+    while (struct dirent *e = readdir(d)) {
+        size_t l = strlen(e->d_name);
+        if (e->d_name[0] != '.' && l > sl && !strcmp(e->d_name + l - sl, suffix)) out.push_back(e->d_name);
+    }
+    closedir(d);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// 読み取り専用のmmap
+class Mapped {
+public:
+    bool open(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            _len = static_cast<size_t>(st.st_size);
+            void *m = mmap(nullptr, _len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) _base = static_cast<const uint8_t *>(m);
+        }
+        close(fd);
+        return _base != nullptr;
+    }
+    ~Mapped() { if (_base) munmap(const_cast<uint8_t *>(_base), _len); }
+    const uint8_t *data() const { return _base; }
+    size_t size() const { return _len; }
+
+private:
+    const uint8_t *_base = nullptr;
+    size_t _len = 0;
+};
+
+/* ================= SEGMENT READER ================= */
+struct Block {
+    BlockHead h;
+    const uint8_t *lens;  // 列の長さ表
+    const uint8_t *cols;  // 列本体の先頭
+};
+
+// ブロックを順に返す。末尾の書きかけや壊れたブロックで止まる
+class Segment {
+public:
+    bool open(const std::string &path, uint32_t magic = BLOCK_MAGIC) { _off = 0; _magic = magic; return _m.open(path); }
+    size_t bytes() const { return _m.size(); }
+
+    bool next(Block &b) {
+        const uint8_t *base = _m.data();
+        if (!base || _off + sizeof(BlockHead) > _m.size()) return false;
+        memcpy(&b.h, base + _off, sizeof(BlockHead));
+        if (b.h.magic != _magic || b.h.n == 0 || _off + sizeof(BlockHead) + b.h.bytes > _m.size()) return false;
+        size_t ncol = leadCols(b.h) + static_cast<size_t>(__builtin_popcountll(b.h.mask));
+        if (ncol * 4 > b.h.bytes) return false;
+        b.lens = base + _off + sizeof(BlockHead);
+        b.cols = b.lens + ncol * 4;
+        _off += sizeof(BlockHead) + b.h.bytes;
+        return true;
+    }
+
+private:
+    Mapped _m;
+    size_t _off = 0;
+    uint32_t _magic = BLOCK_MAGIC;
+};
+
+// 列k（0: 時刻、leadCols以降: mask の立っている順）の範囲
+bool columnAt(const Block &b, size_t k, const uint8_t *&p, const uint8_t *&end) {
+    size_t ncol = leadCols(b.h) + static_cast<size_t>(__builtin_popcountll(b.h.mask));
+    const uint8_t *limit = b.lens + b.h.bytes;
+    p = b.cols;
+    for (size_t i = 0; i < k; i++) { uint32_t l; memcpy(&l, b.lens + i * 4, 4); p += l; }
+    uint32_t l; memcpy(&l, b.lens + k * 4, 4);
+    end = p + l;
+    return k < ncol && end <= limit;
+}
+
+bool decodeTimes(const Block &b, std::vector<uint32_t> &t) {
+    const uint8_t *p, *end;
+    if (!columnAt(b, 0, p, end)) return false;
+    DeltaReader r(p, end);
+    t.resize(b.h.n);
+    t[0] = b.h.t0;
+    for (uint32_t i = 1; i < b.h.n; i++) {
+        int64_t d;
+        if (!r.next(d)) return false;
+        t[i] = t[i - 1] + static_cast<uint32_t>(d);
+    }
+    return true;
+}
+
+size_t fieldCol(const Block &b, int f) { return leadCols(b.h) + static_cast<size_t>(__builtin_popcountll(b.h.mask & ((1ULL << f) - 1))); }
+
+// 項目fの列の値部分。bitmap は有無ビットマップ（全件ありなら nullptr）
+bool fieldColumn(const Block &b, int f, const uint8_t *&bitmap, const uint8_t *&p, const uint8_t *&end) {
+    if (!(b.h.mask >> f & 1)) return false;
+    if (!columnAt(b, fieldCol(b, f), p, end) || p >= end) return false;
+    bitmap = nullptr;
+    if (*p++) { bitmap = p; p += (b.h.n + 7) / 8; if (p > end) return false; }
+    return true;
+}
+
+// 項目fの列を展開する。has[i]=0 は欠測（ブロックに列が無ければ全件欠測）
+bool decodeField(const Block &b, int f, std::vector<int64_t> &v, std::vector<uint8_t> &has) {
+    v.assign(b.h.n, 0);
+    has.assign(b.h.n, 0);
+    if (!(b.h.mask >> f & 1)) return true;
+    const uint8_t *bitmap, *p, *end;
+    if (!fieldColumn(b, f, bitmap, p, end)) return false;
+    DeltaReader r(p, end);
+    for (uint32_t i = 0; i < b.h.n; i++) {
+        if (bitmap && !(bitmap[i / 8] >> (i % 8) & 1)) continue;
+        if (!r.next(v[i])) return false;
+        has[i] = 1;
+    }
+    return true;
+}
+
+// 1分ロールアップのブロックから項目fの各分の集計を展開する（cnt=0 は欠測）
+struct Cell { uint32_t cnt; int64_t mn, mx, sum; };
+bool decodeRollField(const Block &b, int f, std::vector<Cell> &out) {
+    out.assign(b.h.n, Cell{ 0, 0, 0, 0 });
+    if (!(b.h.mask >> f & 1)) return true;
+    const uint8_t *p, *end;
+    if (!columnAt(b, fieldCol(b, f), p, end)) return false;
+    int64_t v;
+    {
+        DeltaReader r(p, end);
+        for (Cell &c : out) { if (!r.next(v)) return false; c.cnt = static_cast<uint32_t>(v); }
+        p = r.pos();
+    }
+    for (int64_t Cell::*a : { &Cell::mn, &Cell::mx, &Cell::sum }) {
+        DeltaReader r(p, end);
+        for (Cell &c : out) if (c.cnt) { if (!r.next(v)) return false; c.*a = v; }
+        p = r.pos();
+    }
+    return true;
+}
+
+/* ================= WRITER ================= */
+// 1台分の書き込み。生データは1時間以内のブロックに溜めてセグメントへ追記する。
+// 1分ロールアップは閉じた分を溜めて生データと一緒に1ブロックで、1時間はバケットが閉じるたびに追記する
+class OvenStore {
+public:
+    OvenStore(const std::string &root, const std::string &id) : id(id), _dir(root + "/" + id) {
+        // 再開: 最新のセグメントの最終時刻より後だけを受け付ける
+        std::vector<std::string> days = listDir(_dir + "/raw", ".seg");
+        if (!days.empty()) {
+            Segment s;
+            Block b;
+            if (s.open(_dir + "/raw/" + days.back())) while (s.next(b)) lastT = std::max(lastT, b.h.t1);
+        }
+    }
+
+    void add(const Rec &r) {
+        if (r.t <= lastT) { dup++; return; }
+        roll(_m, 60, r); // 閉じた分を先に溜め、時間の変わり目のflushに入れる
+        roll(_h, 3600, r);
+        if (!_pend.empty() && (r.t / 3600 != _pend.front().t / 3600 || _pend.size() >= BLOCK_MAX)) flush();
+        if (_pend.empty()) _pendSince = time(nullptr);
+        _pend.push_back(r);
+        lastT = r.t;
+        stored++;
+    }
+
+    // 溜めた生データと閉じた分を、それぞれ1ブロックとして書く（分は月ごとのファイルに分ける）
+    void flush() {
+        if (!_pend.empty()) {
+            std::string blk = encodeBlock(_pend);
+            if (!appendTo(_dir + "/raw/" + dayName(_pend.front().t) + ".seg", blk)) fprintf(stderr, "%s: write failed: %s\n", id.c_str(), strerror(errno));
+            rawBytes += blk.size();
+            _pend.clear();
+        }
+        for (size_t i = 0, j; i < _mins.size(); i = j) {
+            std::string month = monthName(_mins[i].t);
+            for (j = i + 1; j < _mins.size() && monthName(_mins[j].t) == month; j++) {}
+            std::string blk = encodeRollBlock(std::vector<RollAcc>(_mins.begin() + i, _mins.begin() + j));
+            if (!appendTo(_dir + "/1m/" + month + ".seg", blk)) fprintf(stderr, "%s: write failed: %s\n", id.c_str(), strerror(errno));
+            rollBytes += blk.size();
+        }
+        _mins.clear();
+    }
+    bool pendingOlderThan(time_t now, int s) const { return !_pend.empty() && now - _pendSince >= s; }
+
+    // 終了時: 閉じていないバケットも部分集計として書く
+    void close() {
+        if (_m.n) emit(_m, 60);
+        if (_h.n) emit(_h, 3600);
+        _m.n = _h.n = 0;
+        flush();
+    }
+
+    std::string id;
+    uint32_t lastT = 0;
+    uint64_t lines = 0, rejected = 0, dup = 0, stored = 0, rawBytes = 0, rollBytes = 0;
+
+private:
+    void roll(RollAcc &a, uint32_t step, const Rec &r) {
+        uint32_t bucket = r.t - r.t % step;
+        if (a.n && a.t != bucket) emit(a, step);
+        if (!a.n) a.start(bucket);
+        a.add(r);
+    }
+    void emit(RollAcc &a, uint32_t step) {
+        if (step == 60) { _mins.push_back(a); a.n = 0; return; }
+        Roll r = a.out();
+        RollHead h{ ROLL_MAGIC, sizeof(Roll), step, 0 };
+        if (!appendTo(_dir + "/1h.r", std::string(reinterpret_cast<const char *>(&r), sizeof(r)), std::string(reinterpret_cast<const char *>(&h), sizeof(h))))
+            fprintf(stderr, "%s: write failed: %s\n", id.c_str(), strerror(errno));
+        rollBytes += sizeof(r);
+        a.n = 0;
+    }
+
+    std::string _dir;
+    std::vector<Rec> _pend;
+    std::vector<RollAcc> _mins; // 閉じた1分のバケット
+    time_t _pendSince = 0;
+    RollAcc _m, _h;
+};
+
+/* ================= INGEST ================= */
+volatile sig_atomic_t stopRequested = 0;
+void onSignal(int) { stopRequested = 1; }
+
+// 入力元1つ（1台）。ポート/標準入力は受信時刻、ファイルは1行1秒で時刻を振る
+struct Source {
+    std::unique_ptr<OvenStore> store;
+    std::string path;
+    bool live = false, done = false;
+    int fd = -1;
+    std::string buf;
+    uint32_t nextT = 0;
+    time_t retryAt = 0;
+};
+
+bool openSource(Source &s) {
+    if (s.path == "-") { s.fd = 0; s.live = true; return true; }
+    s.fd = ::open(s.path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (s.fd < 0) return false;
+    struct stat st;
+    fstat(s.fd, &st);
+    s.live = !S_ISREG(st.st_mode);
+    if (isatty(s.fd)) {
+        struct termios tio;
+        if (tcgetattr(s.fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            cfsetispeed(&tio, B115200); cfsetospeed(&tio, B115200);
+            tio.c_cflag |= CLOCAL | CREAD;
+            tcsetattr(s.fd, TCSANOW, &tio);
+        }
+        tcflush(s.fd, TCIFLUSH);
+    }
+    return true;
+}
+
+// ファイルの行数を数え、更新時刻で最後の行が終わるように開始時刻を決める
+uint32_t replayStart(const std::string &path) {
+    Mapped m;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return 0;
+    uint64_t lines = 0;
+    if (m.open(path)) {
+        const uint8_t *p = m.data(), *end = p + m.size();
+        while ((p = static_cast<const uint8_t *>(memchr(p, '\n', static_cast<size_t>(end - p))))) { lines++; p++; }
+    }
+    return static_cast<uint32_t>(st.st_mtime - static_cast<time_t>(lines));
+}
+
+void consume(Source &s, const char *b, const char *e) {
+    if (e > b && e[-1] == '\r') e--;
+    OvenStore &o = *s.store;
+    uint32_t t;
+    if (s.live) {
+        // ホスト側のバッファで2行が同じ秒に届いても順序を保つ（送信は1行/秒なので遅れは溜まらない）
+        t = std::max(static_cast<uint32_t>(time(nullptr)), o.lastT + 1);
+    } else {
+        t = s.nextT++;
+    }
+    if (b == e) return;
+    o.lines++;
+    Rec r;
+    if (!parseLine(b, e, r)) { o.rejected++; return; }
+    r.t = t;
+    o.add(r);
+}
+
+// 読めた分を行に切って取り込む。EOF/切断でfalse
+bool pump(Source &s) {
+    char tmp[1 << 16];
+    ssize_t n = read(s.fd, tmp, sizeof(tmp));
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) return true;
+    if (n <= 0) {
+        if (!s.live && !s.buf.empty()) { consume(s, s.buf.data(), s.buf.data() + s.buf.size()); s.buf.clear(); }
+        return false;
+    }
+    s.buf.append(tmp, static_cast<size_t>(n));
+    size_t at = 0;
+    for (;;) {
+        const char *base = s.buf.data();
+        const char *nl = static_cast<const char *>(memchr(base + at, '\n', s.buf.size() - at));
+        if (!nl) break;
+        consume(s, base + at, nl);
+        at = static_cast<size_t>(nl - base) + 1;
+    }
+    s.buf.erase(0, at);
+    if (s.buf.size() > 4096) s.buf.clear(); // 改行の来ないゴミ
+    return true;
+}
+
+int ingest(const std::string &root, const std::vector<std::pair<std::string, std::string>> &ovens, int64_t start, int flushS) {
+    std::vector<Source> src(ovens.size());
+    for (size_t i = 0; i < ovens.size(); i++) {
+        Source &s = src[i];
+        s.store.reset(new OvenStore(root, ovens[i].first));
+        s.path = ovens[i].second;
+        if (!openSource(s)) { fprintf(stderr, "%s: %s\n", s.path.c_str(), strerror(errno)); return 1; }
+        if (!s.live) s.nextT = start >= 0 ? static_cast<uint32_t>(start) : replayStart(s.path);
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    while (!stopRequested) {
+        bool files = false, any = false;
+        std::vector<struct pollfd> pfd;
+        std::vector<Source *> who;
+        time_t now = time(nullptr);
+        for (Source &s : src) {
+            if (s.done) continue;
+            any = true;
+            if (s.fd < 0) {
+                // 抜けたポートは一定間隔で開き直す
+                if (now >= s.retryAt && openSource(s)) fprintf(stderr, "%s: reconnected\n", s.path.c_str());
+                else if (s.fd < 0) { s.retryAt = std::max(s.retryAt, now + 5); continue; }
+            }
+            if (!s.live) {
+                files = true;
+                if (!pump(s)) { close(s.fd); s.fd = -1; s.done = true; s.store->flush(); }
+                continue;
+            }
+            pfd.push_back({ s.fd, POLLIN, 0 });
+            who.push_back(&s);
+        }
+        if (!any) break;
+        if (!pfd.empty() && poll(pfd.data(), pfd.size(), files ? 0 : 1000) > 0) {
+            for (size_t i = 0; i < pfd.size(); i++) {
+                if (!(pfd[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                Source &s = *who[i];
+                if (!pump(s)) {
+                    fprintf(stderr, "%s: disconnected\n", s.path.c_str());
+                    if (s.fd > 0) close(s.fd);
+                    if (s.path == "-") s.done = true;
+                    s.fd = -1; s.buf.clear(); s.retryAt = time(nullptr) + 5;
+                }
+            }
+        } else if (pfd.empty() && !files) {
+            sleep(1);
+        }
+        // ライブ入力は --flush 秒ごとに書き出す（落ちても失うのはその間だけ）
+        now = time(nullptr);
+        for (Source &s : src) if (s.live && s.store->pendingOlderThan(now, flushS)) s.store->flush();
+    }
+
+    for (Source &s : src) {
+        OvenStore &o = *s.store;
+        o.close();
+        printf("%s: %" PRIu64 " lines, %" PRIu64 " stored, %" PRIu64 " rejected, %" PRIu64 " already stored, raw %.1f kB (%.2f B/line), rollups %.1f kB\n",
+               o.id.c_str(), o.lines, o.stored, o.rejected, o.dup, o.rawBytes / 1024.0, o.stored ? static_cast<double>(o.rawBytes) / o.stored : 0.0,
+               o.rollBytes / 1024.0);
+    }
+    return 0;
+}
+
+/* ================= QUERY ================= */
+enum AggMode { AGG_AVG, AGG_MIN, AGG_MAX, AGG_COUNT };
+
+struct Acc {
+    double sum = 0; float mn = 0, mx = 0; uint64_t cnt = 0;
+    void add(float lo, float hi, double s, uint64_t n) {
+        if (!n) return;
+        if (!cnt) { mn = lo; mx = hi; } else { mn = std::min(mn, lo); mx = std::max(mx, hi); }
+        sum += s; cnt += n;
+    }
+    double value(AggMode m) const {
+        switch (m) {
+            case AGG_MIN: return mn;
+            case AGG_MAX: return mx;
+            case AGG_COUNT: return static_cast<double>(cnt);
+            default: return sum / cnt;
+        }
+    }
+};
+
+struct Range {
+    int64_t from, to;  // stepの境界に丸めた [from, to)
+    uint32_t step;     // 0: 生データをそのまま出す
+    size_t buckets() const { return step ? static_cast<size_t>((to - from) / step) : 0; }
+};
+
+// 生データのブロックのうち [from, to) に掛かるものを順に渡す
+template <typename F> void scanRaw(const std::string &dir, int64_t from, int64_t to, F &&fn) {
+    for (const std::string &name : listDir(dir + "/raw", ".seg")) {
+        std::string day = name.substr(0, 10);
+        if (day < dayName(static_cast<uint32_t>(from)) || day > dayName(static_cast<uint32_t>(to - 1))) continue;
+        Segment s;
+        Block b;
+        if (!s.open(dir + "/raw/" + name)) continue;
+        while (s.next(b)) if (b.h.t1 >= from && b.h.t0 < to) fn(b);
+    }
+}
+
+// ロールアップの [from, to) のバケットを fn(時刻, fields内の番号, 最小, 最大, 合計, 件数) で項目ごとに渡す
+template <typename F> void scanRollups(const std::string &dir, uint32_t res, int64_t from, int64_t to, const std::vector<int> &fields, F &&fn) {
+    if (res == 60) {
+        std::vector<uint32_t> t;
+        std::vector<Cell> c;
+        for (const std::string &name : listDir(dir + "/1m", ".seg")) {
+            std::string month = name.substr(0, 7);
+            if (month < monthName(static_cast<uint32_t>(from)) || month > monthName(static_cast<uint32_t>(to - 1))) continue;
+            Segment s;
+            Block b;
+            if (!s.open(dir + "/1m/" + name, ROLL_BLOCK_MAGIC)) continue;
+            while (s.next(b)) {
+                if (b.h.t1 < from || b.h.t0 >= to || !decodeTimes(b, t)) continue;
+                for (size_t k = 0; k < fields.size(); k++) {
+                    if (!decodeRollField(b, fields[k], c)) break;
+                    for (uint32_t i = 0; i < b.h.n; i++)
+                        if (c[i].cnt && t[i] >= from && t[i] < to) fn(t[i], k, c[i].mn / 100.0f, c[i].mx / 100.0f, c[i].sum / 100.0, c[i].cnt);
+                }
+            }
+        }
+        return;
+    }
+    std::string path = dir + "/1h.r";
+    Mapped m;
+    if (!m.open(path) || m.size() < sizeof(RollHead)) return;
+    RollHead h;
+    memcpy(&h, m.data(), sizeof(h));
+    if (h.magic != ROLL_MAGIC || h.recSize != sizeof(Roll)) { fprintf(stderr, "%s: unknown format\n", path.c_str()); return; }
+    const Roll *r = reinterpret_cast<const Roll *>(m.data() + sizeof(RollHead));
+    size_t n = (m.size() - sizeof(RollHead)) / sizeof(Roll);
+    // 時刻順に追記されているので二分探索で開始位置を決める
+    size_t i = static_cast<size_t>(std::lower_bound(r, r + n, from, [](const Roll &x, int64_t t) { return x.t < t; }) - r);
+    for (; i < n && r[i].t < to; i++) {
+        for (size_t k = 0; k < fields.size(); k++) {
+            const Agg &a = r[i].a[fields[k]];
+            fn(r[i].t, k, a.mn, a.mx, static_cast<double>(a.avg) * a.cnt, a.cnt);
+        }
+    }
+}
+
+void query(const std::string &dir, const std::vector<int> &fields, const Range &q, AggMode mode) {
+    printf("# time");
+    for (int f : fields) printf("\t%s", FIELD_KEYS[f]);
+    printf("\n");
+    std::vector<uint32_t> t;
+    std::vector<std::vector<int64_t>> v(fields.size());
+    std::vector<std::vector<uint8_t>> has(fields.size());
+
+    if (!q.step) {
+        scanRaw(dir, q.from, q.to, [&](const Block &b) {
+            if (!decodeTimes(b, t)) return;
+            for (size_t k = 0; k < fields.size(); k++) if (!decodeField(b, fields[k], v[k], has[k])) return;
+            for (uint32_t i = 0; i < b.h.n; i++) {
+                if (t[i] < q.from || t[i] >= q.to) continue;
+                printf("%s", isoTime(t[i]).c_str());
+                for (size_t k = 0; k < fields.size(); k++) {
+                    if (has[k][i]) printf("\t%.2f", v[k][i] / 100.0); else printf("\t-");
+                }
+                printf("\n");
+            }
+        });
+        return;
+    }
+
+    size_t nb = q.buckets(), nf = fields.size();
+    std::vector<Acc> acc(nb * nf);
+    if (q.step % 3600 == 0 || q.step % 60 == 0) {
+        uint32_t res = q.step % 3600 == 0 ? 3600 : 60;
+        scanRollups(dir, res, q.from, q.to, fields, [&](uint32_t t, size_t k, float mn, float mx, double sum, uint32_t cnt) {
+            acc[static_cast<size_t>((t - q.from) / q.step) * nf + k].add(mn, mx, sum, cnt);
+        });
+    } else {
+        scanRaw(dir, q.from, q.to, [&](const Block &b) {
+            if (!decodeTimes(b, t)) return;
+            for (size_t k = 0; k < nf; k++) {
+                if (!decodeField(b, fields[k], v[k], has[k])) return;
+                for (uint32_t i = 0; i < b.h.n; i++) {
+                    if (!has[k][i] || t[i] < q.from || t[i] >= q.to) continue;
+                    float x = v[k][i] / 100.0f;
+                    acc[static_cast<size_t>((t[i] - q.from) / q.step) * nf + k].add(x, x, v[k][i] / 100.0, 1);
+                }
+            }
+        });
+    }
+    for (size_t b = 0; b < nb; b++) {
+        bool any = false;
+        for (size_t k = 0; k < nf; k++) any |= acc[b * nf + k].cnt > 0;
+        if (!any) continue;
+        printf("%s", isoTime(q.from + static_cast<int64_t>(b) * q.step).c_str());
+        for (size_t k = 0; k < nf; k++) {
+            const Acc &a = acc[b * nf + k];
+            if (a.cnt) printf("\t%.2f", a.value(mode)); else printf("\t-");
+        }
+        printf("\n");
+    }
+}
+
+// ST列から state が始まって until に移るまでの時間を拾う。途中で記録が途切れた区間は数えない
+void runs(const std::string &dir, const Range &q, int state, int until) {
+    constexpr uint32_t GAP_S = 5;
+    constexpr int64_t BOOT_WH = 200; // EU+EL（×100）がこれ未満なら起動直後（全出力でも数秒分）
+    struct Stat { uint64_t n = 0; double sum = 0; uint32_t mn = 0, mx = 0; };
+    std::vector<Stat> st(q.step ? q.buckets() : 0);
+    std::vector<uint32_t> t;
+    std::vector<int64_t> v;
+    std::vector<uint8_t> has;
+    std::vector<int64_t> ev;
+    std::vector<uint8_t> eh;
+    // ブロックbのi件目が起動直後か（EU/ELは起動からの積算なのでほぼ0）
+    auto booted = [&](const Block &b, uint32_t i) {
+        int64_t wh = 0;
+        for (int f : { F_EU, F_EL }) {
+            if (!decodeField(b, f, ev, eh) || !eh[i]) return false;
+            wh += ev[i];
+        }
+        return wh < BOOT_WH;
+    };
+    int prev = -1;
+    uint32_t prevT = 0, startT = 0;
+    bool inRun = false;
+    // 状態 s が時刻 tf..tl の間続いた（ブロックbのi件目から）
+    auto hold = [&](uint32_t tf, uint32_t tl, int s, const Block &b, uint32_t i) {
+        if (prev >= 0 && tf - prevT > GAP_S) { inRun = false; prev = -1; }
+        if (s != prev) {
+            if (inRun && s == until) {
+                uint32_t d = tf - startT;
+                if (q.step) {
+                    Stat &x = st[static_cast<size_t>((startT - q.from) / q.step)];
+                    if (!x.n++) x.mn = x.mx = d; else { x.mn = std::min(x.mn, d); x.mx = std::max(x.mx, d); }
+                    x.sum += d;
+                } else {
+                    printf("%s\t%u\n", isoTime(startT).c_str(), d);
+                }
+            }
+            // 記録の途中から始まった区間は所要時間が分からないので数えない。
+            // ただし起動直後の記録から始まった区間（電源投入からの予熱）は数える
+            inRun = s == state && (prev >= 0 || booted(b, i));
+            startT = tf;
+        }
+        prev = s;
+        prevT = tl;
+    };
+    if (q.step) printf("# time\truns\tavg_s\tmin_s\tmax_s\n"); else printf("# start\tseconds\n");
+    scanRaw(dir, q.from, q.to, [&](const Block &b) {
+        // 範囲内で途切れの無いブロックは、ST列の変化点だけを追う（展開しない）
+        const uint8_t *bitmap, *p, *end;
+        if (b.h.t0 >= q.from && b.h.t1 < q.to && b.h.t1 - b.h.t0 == b.h.n - 1 && fieldColumn(b, F_ST, bitmap, p, end) && !bitmap) {
+            DeltaReader r(p, end);
+            for (uint32_t i = 0; i < b.h.n;) {
+                int64_t s;
+                if (!r.next(s)) return;
+                uint32_t len = static_cast<uint32_t>(std::min<uint64_t>(r.repeats(), b.h.n - i - 1)) + 1;
+                r.skip();
+                hold(b.h.t0 + i, b.h.t0 + i + len - 1, static_cast<int>(s / 100), b, i);
+                i += len;
+            }
+            return;
+        }
+        if (!decodeTimes(b, t) || !decodeField(b, F_ST, v, has)) return;
+        for (uint32_t i = 0; i < b.h.n; i++) {
+            if (has[i] && t[i] >= q.from && t[i] < q.to) hold(t[i], t[i], static_cast<int>(v[i] / 100), b, i);
+        }
+    });
+    for (size_t b = 0; b < st.size(); b++) {
+        if (!st[b].n) continue;
+        printf("%s\t%" PRIu64 "\t%.0f\t%u\t%u\n", isoTime(q.from + static_cast<int64_t>(b) * q.step).c_str(), st[b].n, st[b].sum / st[b].n, st[b].mn, st[b].mx);
+    }
+}
+
+void info(const std::string &root) {
+    DIR *d = opendir(root.c_str());
+    if (!d) { fprintf(stderr, "%s: %s\n", root.c_str(), strerror(errno)); return; }
+    std::vector<std::string> ovens;
+    while (struct dirent *e = readdir(d)) if (e->d_name[0] != '.') ovens.push_back(e->d_name);
+    closedir(d);
+    std::sort(ovens.begin(), ovens.end());
+    for (const std::string &id : ovens) {
+        std::string dir = root + "/" + id;
+        std::vector<std::string> days = listDir(dir + "/raw", ".seg");
+        uint64_t recs = 0, blocks = 0, bytes = 0;
+        uint32_t first = UINT32_MAX, last = 0;
+        for (const std::string &name : days) {
+            Segment s;
+            Block b;
+            if (!s.open(dir + "/raw/" + name)) continue;
+            bytes += s.bytes();
+            while (s.next(b)) { recs += b.h.n; blocks++; first = std::min(first, b.h.t0); last = std::max(last, b.h.t1); }
+        }
+        uint64_t rollBytes = 0;
+        struct stat st;
+        for (const std::string &name : listDir(dir + "/1m", ".seg")) if (stat((dir + "/1m/" + name).c_str(), &st) == 0) rollBytes += static_cast<uint64_t>(st.st_size);
+        if (stat((dir + "/1h.r").c_str(), &st) == 0) rollBytes += static_cast<uint64_t>(st.st_size);
+        printf("%s: %s .. %s, %zu segments, %" PRIu64 " blocks, %" PRIu64 " records, raw %.1f MB (%.2f B/record), rollups %.1f MB\n",
+               id.c_str(), recs ? isoTime(first).c_str() : "-", recs ? isoTime(last).c_str() : "-", days.size(), blocks, recs,
+               bytes / 1048576.0, recs ? static_cast<double>(bytes) / recs : 0.0, rollBytes / 1048576.0);
+    }
+}
+
+/* ================= CLI ================= */
+// "2026-07-01", "2026-07-01T08:00[:00]"（UTC）, UNIX秒, "now", "-90d"/"-12h"/"-30m"（現在から）
+bool parseTime(const char *s, int64_t &out) {
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    if (!strcmp(s, "now")) { out = now; return true; }
+    char *e;
+    if (s[0] == '-') {
+        long long n = strtoll(s + 1, &e, 10);
+        int64_t unit = *e == 'd' ? 86400 : *e == 'h' ? 3600 : *e == 'm' ? 60 : *e == 's' ? 1 : 0;
+        if (!unit || e[1]) return false;
+        out = now - n * unit;
+        return true;
+    }
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    int y, mo, d, h = 0, mi = 0, sec = 0, k = 0;
+    if (sscanf(s, "%d-%d-%d%n", &y, &mo, &d, &k) == 3) {
+        const char *p = s + k;
+        if (*p == 'T' || *p == ' ') {
+            int c = sscanf(p + 1, "%d:%d:%d", &h, &mi, &sec);
+            if (c < 2) return false;
+        } else if (*p) {
+            return false;
+        }
+        tm.tm_year = y - 1900; tm.tm_mon = mo - 1; tm.tm_mday = d; tm.tm_hour = h; tm.tm_min = mi; tm.tm_sec = sec;
+        out = static_cast<int64_t>(timegm(&tm));
+        return true;
+    }
+    long long v = strtoll(s, &e, 10);
+    if (!*s || *e) return false;
+    out = v;
+    return true;
+}
+
+// "raw"=0, "30s", "1m", "1h", "7d"
+bool parseStep(const char *s, uint32_t &out) {
+    if (!strcmp(s, "raw")) { out = 0; return true; }
+    char *e;
+    unsigned long n = strtoul(s, &e, 10);
+    uint32_t unit = *e == 'd' ? 86400 : *e == 'h' ? 3600 : *e == 'm' ? 60 : (*e == 's' || !*e) ? 1 : 0;
+    if (!unit || n == 0 || (*e && e[1])) return false;
+    out = static_cast<uint32_t>(n) * unit;
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: telstore ingest DIR --oven ID=PORT|FILE|- [--oven ...] [options]\n"
+        "  --start TIME       time of the first line of a FILE (default: file ends at its mtime)\n"
+        "  --flush S          write live data to disk at least every S seconds (default 300)\n"
+        "       telstore query DIR --oven ID --field F[,F...] [options]\n"
+        "  --from/--to TIME   range (default: everything up to now)\n"
+        "  --step STEP        raw | Ns | Nm | Nh | Nd (default: a few hundred rows)\n"
+        "  --agg MODE         avg | min | max | count (default avg)\n"
+        "       telstore runs DIR --oven ID [options]\n"
+        "  --state S          state whose duration is measured (default PREHEAT)\n"
+        "  --until S          state that ends it (default READY)\n"
+        "  --from/--to/--step as for query; without --step every run is listed\n"
+        "       telstore info DIR\n"
+        "TIME: 2026-07-01[T08:00[:00]] (UTC) | unix seconds | now | -90d | -12h | -30m\n");
+}
+
+bool validId(const std::string &id) {
+    if (id.empty()) return false;
+    for (char c : id) if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-') return false;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) { usage(); return 2; }
+    std::string cmd = argv[1], root = argv[2];
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+
+    std::vector<std::pair<std::string, std::string>> ovens;
+    std::string oven;
+    std::vector<int> fields;
+    int64_t from = 0, to = static_cast<int64_t>(time(nullptr)) + 1, start = -1;
+    bool hasStep = false;
+    uint32_t step = 0;
+    int flushS = 300, state = 1, until = 2;
+    AggMode mode = AGG_AVG;
+    for (int i = 3; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!v) { usage(); return 2; }
+        bool ok = true;
+        if (!strcmp(a, "--oven")) {
+            const char *eq = strchr(v, '=');
+            if (cmd == "ingest") {
+                if (!eq) ok = false; else ovens.emplace_back(std::string(v, eq), std::string(eq + 1));
+                ok = ok && validId(ovens.back().first);
+            } else {
+                oven = v; ok = validId(oven);
+            }
+        } else if (!strcmp(a, "--field")) {
+            std::string s = v;
+            for (size_t p = 0; ok && p <= s.size();) {
+                size_t c = s.find(',', p);
+                if (c == std::string::npos) c = s.size();
+                int f = fieldByName(s.substr(p, c - p).c_str());
+                if (f < 0) { fprintf(stderr, "unknown field: %s\n", s.substr(p, c - p).c_str()); return 2; }
+                fields.push_back(f);
+                p = c + 1;
+            }
+        } else if (!strcmp(a, "--from")) ok = parseTime(v, from);
+        else if (!strcmp(a, "--to")) ok = parseTime(v, to);
+        else if (!strcmp(a, "--start")) ok = parseTime(v, start);
+        else if (!strcmp(a, "--step")) ok = hasStep = parseStep(v, step);
+        else if (!strcmp(a, "--flush")) ok = (flushS = atoi(v)) > 0;
+        else if (!strcmp(a, "--state")) ok = (state = stateByName(v)) >= 0;
+        else if (!strcmp(a, "--until")) ok = (until = stateByName(v)) >= 0;
+        else if (!strcmp(a, "--agg")) {
+            if (!strcmp(v, "avg")) mode = AGG_AVG;
+            else if (!strcmp(v, "min")) mode = AGG_MIN;
+            else if (!strcmp(v, "max")) mode = AGG_MAX;
+            else if (!strcmp(v, "count")) mode = AGG_COUNT;
+            else ok = false;
+        } else ok = false;
+        if (!ok) { fprintf(stderr, "bad argument: %s %s\n", a, v); usage(); return 2; }
+        i++;
+    }
+
+    if (cmd == "ingest") {
+        if (ovens.empty()) { usage(); return 2; }
+        return ingest(root, ovens, start, flushS);
+    }
+    if (cmd == "info") { info(root); return 0; }
+    if ((cmd != "query" && cmd != "runs") || oven.empty() || (cmd == "query" && fields.empty())) { usage(); return 2; }
+
+    // 既定の step は範囲に応じて数百行程度になるように選ぶ
+    if (!hasStep) {
+        int64_t span = to - from;
+        step = cmd == "runs" ? 0 : span <= 6 * 3600 ? 60 : span <= 14 * 86400 ? 3600 : 86400;
+    }
+    Range q{ from, to, step };
+    if (step) {
+        q.from = from - ((from % step) + step) % step;
+        q.to = to + (step - ((to % step) + step) % step) % step;
+        if (q.buckets() > 50000000) { fprintf(stderr, "too many buckets; use a larger --step\n"); return 2; }
+    }
+    if (q.to <= q.from) return 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::string dir = root + "/" + oven;
+    if (cmd == "query") query(dir, fields, q, mode);
+    else runs(dir, q, state, until);
+    fflush(stdout);
+    fprintf(stderr, "# %.1f ms\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    return 0;
+}
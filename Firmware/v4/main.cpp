@@ -2,7 +2,7 @@
  * PIZZA COOKER OS v4.4
  * ---------------------------------------------------------------
  * [主要機能]
- * ・二重化熱電対によるヒーター/プレートの個別温度監視
+ * ・二重化熱電対によるヒーター/プレートの個別温度監視（MAX6675/MAX31855/MAX31856）
  * ・PID制御およびオートチューニング機能
  * ・電力制限枠内での動的PWM配分（下火優先アルゴリズム）
  * ・ストーン熱浸透度（Soak）の計算と自動焼き開始判定
@@ -10,7 +10,7 @@
 
 #include <Arduino.h>
 #include <EEPROM.h>
-#include <max6675.h>
+#include <SPI.h>
 #include <PID_AutoTune_v0.h>
 #include <U8x8lib.h>
 #include <avr/wdt.h>
@@ -21,16 +21,25 @@ static inline float f_abs(float v) { return (v < 0.0f) ? -v : v; }
 /* ================= CONFIGURATION ================= */
 namespace Config {
     // EEPROMのデータ構造が変わった際に初期化を強制するための識別子
-    constexpr uint32_t EEPROM_MAGIC = 0x50495A36; 
+    constexpr uint32_t EEPROM_MAGIC = 0x50495A3A; 
+
+    // 熱電対アンプの品種（4個とも同じ品種を実装する）
+    namespace Thermo {
+        enum Chip : uint8_t { MAX6675, MAX31855, MAX31856 };
+        constexpr uint8_t CHIP = MAX6675;
+        // アンプが報告する異常（Thermocouple::read()の戻り値）
+        enum Fault : uint8_t { F_OPEN = 1, F_SHORT = 2, F_RANGE = 4, F_BUS = 8 };
+    }
 
     namespace Pins {
-        constexpr uint8_t THERMO_CLK   = 15, THERMO_DO = 14;
+        // 熱電対アンプはハードウェアSPI（SCK=15, MISO=14, MOSI=16）を共有し、CSで選択
         constexpr uint8_t CS_UP_PLATE  = A1, CS_UP_HEATER  = A0; // 上火（プレート/ヒーター）
         constexpr uint8_t CS_LO_PLATE  = A3, CS_LO_HEATER  = A2; // 下火（プレート/ヒーター）
         constexpr uint8_t SSR_UP       = 5,   SSR_LO       = 6;  // PWM制御用SSR
         constexpr uint8_t SAFETY_RELAY = 9;                      // 主電源遮断用リレー
         constexpr uint8_t ENC_CLK      = 7,   ENC_DT       = 8;  // ロータリーエンコーダ
         constexpr uint8_t ENC_SW       = 4;                      // エンコーダプッシュスイッチ
+        constexpr uint8_t MAINS_CT     = A10;                    // 主電源の電流センサー（Mains::SENSOR時）
     }
 
     namespace Hard {
@@ -43,9 +52,86 @@ namespace Config {
         constexpr uint32_t RUNAWAY_TIMEOUT_MS   = 30000UL; // 暴走判定（出力0で温度上昇時）
         constexpr uint32_t REST_TIMEOUT_MS      = 30UL * 60UL * 1000UL; // 無操作自動停止
         constexpr uint32_t EEPROM_IDLE_TIMEOUT_MS = 30000UL; // 書き込み待機時間
-        constexpr uint32_t BOOST_MS             = 30000UL;    // 投入直後の電力ブースト時間
+        constexpr uint32_t BOOST_MS             = 30000UL;    // 投入直後の電力ブースト時間（Settingsの初期値）
         constexpr uint32_t BAKE_DONE_MSG_MS     = 3000UL;    // 完了メッセージ表示時間
         constexpr float    TUNE_TARGET_C        = 350.0f;    // オートチューニング目標
+        // [焼成熱量] 焼き時間はレシピの設定温度で焼いた場合の秒数を必要熱量とみなし、
+        // 実際のストーン温度と天井の放射から積算した熱量が達した時点で終了する
+        constexpr float    DOUGH_C              = 100.0f;    // 生地表面温度（水の沸点で頭打ち）
+        constexpr uint8_t  BAKE_MIN_PCT         = 80;        // 標準焼き時間に対する下限 [%]
+        constexpr uint8_t  BAKE_MAX_PCT         = 150;       // 標準焼き時間に対する上限 [%]
+        constexpr uint16_t BAKE_SEC_MAX         = 3600;      // 標準焼き時間の上限（レシピと r.bake）[s]
+        // [熱モデル] プレート温度の一次遅れモデル dT/dt = a·u - b·(T - 室温) の初期値（運転中に学習）
+        constexpr float    AMBIENT_C            = 25.0f;
+        constexpr float    MODEL_UP_A           = 1.5f,   MODEL_UP_B = 0.0024f; // a:[℃/s] b:[1/s]
+        constexpr float    MODEL_LO_A           = 0.8f,   MODEL_LO_B = 0.0016f;
+        // [エコ保温] 無操作時は温度を下げて保温し、ECO_RETURN_S 以内にREADYへ戻れる温度を維持する
+        constexpr uint16_t ECO_RETURN_S         = 300;       // 復帰時間の保証値
+        constexpr float    ECO_MARGIN           = 0.85f;     // モデル誤差に対する余裕（時間に乗じる）
+        constexpr float    ECO_MIN_C            = 150.0f;    // 保温温度の下限
+        constexpr uint32_t ECO_MAX_MS           = 4UL * 60UL * 60UL * 1000UL; // これ以上無操作ならREST
+        // [予約予熱] 指定時刻にREADYとなるよう、加熱の開始を遅らせて出力を抑える（シリアルの ready コマンド）
+        constexpr float    PLAN_SLACK           = 0.05f;     // 最小電力量に対して許す増加分（素線温度を下げるため）
+        constexpr float    PLAN_MARGIN          = 0.9f;      // モデル誤差に対する余裕（残り時間に乗じる）
+        constexpr float    PLAN_HOLD_K          = 0.01f;     // 実際の保持出力の平滑化係数（1秒ごと）
+        constexpr uint16_t PLAN_MAX_MIN         = 24U * 60U; // 予約できる最長時間 [min]
+        // [目標軌道] 目標の段差を、熱モデルの加熱・放熱能力に合わせた速度・加速度制限付きの軌道にしてPIDに与える
+        constexpr float    TRAJ_RATE            = 0.96f;     // 昇温: 加熱能力に対する速度の割合（残りはPIDの追従分）
+        constexpr float    TRAJ_ACCEL           = 0.0026f;   // 昇温: 加速度の上限 [℃/s²]（大きいと到達後に行き過ぎる）
+        constexpr float    TRAJ_RATE_DN         = 0.9f;      // 降温: 放熱能力に対する速度の割合
+        constexpr float    TRAJ_ACCEL_DN        = 0.0075f;   // 降温: 加速度の上限 [℃/s²]（ヒーター停止で止まるため昇温より大きくとれる）
+        constexpr float    TRAJ_LAG_S           = 28.0f;     // 素線からプレートへの伝熱の遅れ [s]。軌道の加速度分をこの時間だけ先回りして与える
+        constexpr float    TRAJ_LEAD_C          = 25.0f;     // 実温度からの先行の上限（電力制限やモデル誤差で遅れた場合）
+        constexpr float    READY_BAND_C         = 5.0f;      // READY判定の温度誤差（Settingsの初期値）
+        constexpr uint8_t  SOAK_READY_PCT       = 95;        // READY判定のSoak閾値（Settingsの初期値）
+        // [サンプリング] 熱電対アンプの変換時間に余裕を足した間隔で連続取得し、中央値で判定
+        // MAX6675(220ms)では250ms間隔、MAX31855/31856(100ms)では130ms間隔になる
+        constexpr uint32_t SAMPLE_MARGIN_MS     = 30UL;
+        constexpr uint8_t  SAMPLE_RING          = 5;         // 中央値を取るサンプル数（MAX6675で約1.25秒分）
+        constexpr uint32_t SENSOR_PERSIST_MS    = 2000UL;    // 有効値が途絶えてからエラー確定まで
+        constexpr float    PLATE_RATE_MAX_C     = 40.0f;     // 物理的にあり得るプレート温度変化 [℃/s]
+        constexpr float    HEATER_RATE_MAX_C    = 150.0f;    // 物理的にあり得るヒーター温度変化 [℃/s]
+        // 断線時のエラー確定は最悪でも、中央値が無効になるまで（過半数のサンプルの取得）+ SENSOR_PERSIST_MS を
+        // 制御周期(1s)で切り上げた時間（MAX6675で 0.75 + 3 = 3.75秒。IntelligentHeater::TRIP_MAX_MS）
+    }
+
+    // [ゾーン構成] ゾーン数と各ゾーンのピン・定格・配分優先度
+    // ゾーン配列・設定のレイアウト・電力配分・表示はこの表からコンパイル時に生成する
+    // 例: 2段窯（4ヒーター）は各段のTOP/BOTTOMを並べ、下段から順に優先度を付ける
+    namespace Zones {
+        enum Role : uint8_t { TOP, BOTTOM }; // BOTTOMはストーン（レシピの下火温度・Boostの対象）
+        struct Zone {
+            char name[3];                    // シリアルコマンドの接頭辞（"up.kp" など）
+            char tag;                        // 温度表示の見出し
+            uint8_t csPlate, csHeater, ssr;
+            float ratedW;
+            uint8_t priority;                // 電力配分の順位（0が最優先、ゾーン間で重複不可）
+            Role role;
+            float modelA, modelB;            // 熱モデルの初期値
+        };
+        constexpr Zone TABLE[] = {
+            { "up", 'U', Pins::CS_UP_PLATE, Pins::CS_UP_HEATER, Pins::SSR_UP, Hard::RATED_UP_W, 1, TOP,
+              Hard::MODEL_UP_A, Hard::MODEL_UP_B },
+            { "lo", 'L', Pins::CS_LO_PLATE, Pins::CS_LO_HEATER, Pins::SSR_LO, Hard::RATED_LO_W, 0, BOTTOM,
+              Hard::MODEL_LO_A, Hard::MODEL_LO_B },
+        };
+        constexpr uint8_t CNT = sizeof(TABLE) / sizeof(Zone);
+
+        constexpr uint8_t firstOf(Role r, uint8_t i = 0) { return (i >= CNT || TABLE[i].role == r) ? i : firstOf(r, i + 1); }
+        constexpr uint8_t byPriority(uint8_t rank, uint8_t i = 0) {
+            return (i >= CNT || TABLE[i].priority == rank) ? i : byPriority(rank, i + 1);
+        }
+        constexpr bool priorityValid(uint8_t rank = 0) { return rank >= CNT || (byPriority(rank) < CNT && priorityValid(rank + 1)); }
+        static_assert(priorityValid(), "zone priorities must be 0..CNT-1 without duplicates");
+
+        // 上火/下火の代表ゾーン（予約予熱の計画・テレメトリ・表示はこの2つで判断する）
+        constexpr uint8_t UP = firstOf(TOP), LO = firstOf(BOTTOM);
+        static_assert(UP < CNT && LO < CNT, "at least one TOP and one BOTTOM zone are required");
+        // 役割ごとの定格の合計（予約予熱の計画は役割ごとにまとめて扱う）
+        constexpr float roleW(Role r, uint8_t i = 0) {
+            return (i >= CNT) ? 0.0f : ((TABLE[i].role == r) ? TABLE[i].ratedW : 0.0f) + roleW(r, i + 1);
+        }
+        static_assert(CNT <= 8, "the display shows at most 8 zones");
     }
 
     namespace Msg {
@@ -55,22 +141,93 @@ namespace Config {
         const char DONE[] PROGMEM      = "Well done. Ciao!";
         const char ERROR[] PROGMEM     = "Safety Stop";
         const char BAKE_DONE[] PROGMEM = "Buon appetito!";
+        const char ECO[] PROGMEM       = "Eco hold";
+        const char PLANNED[] PROGMEM   = "Ready on time";
     }
 
 #pragma pack(push, 1) // メモリ節約のためパディングを禁止
     struct Recipe {
         char name[8];
-        float upC, loC;      // 目標温度
-        char readyMsg[22];   // 到達時メッセージ
-        uint16_t bakeSec;    // 標準焼き時間
+        uint16_t upC, loC;   // 目標温度 [℃]
+        char readyMsg[17];   // 到達時メッセージ（ステータス行の16文字）
+        uint16_t bakeSec;    // 標準焼き時間（設定温度での必要熱量を秒換算したもの）
+        uint8_t loPct;       // 必要熱量のうち下火（ストーン伝導）が占める割合 [%]
     };
 #pragma pack(pop)
 
-    const Recipe recipes[] PROGMEM = {
-        {"Napoli", 500.0f, 430.0f, "Pizza Time",     90},
-        {"Romana", 330.0f, 310.0f, "Crispy Romana", 180}
-    };
+    // [レシピ一覧] X(名前, 上火℃, 下火℃, 到達メッセージ, 焼き時間s, 下火%)
+    // ここに行を足すだけでPROGMEM上の配列が生成される。RAM使用量はレシピ数に依存しない
+#define EL_PICO_RECIPES(X) \
+    X("Napoli",  500, 430, "Pizza Time",        90, 45) \
+    X("Romana",  330, 310, "Crispy Romana",    180, 60) \
+    X("Marghe",  485, 430, "Margherita!",       90, 45) \
+    X("Marinar", 490, 430, "Marinara",          80, 45) \
+    X("Diavola", 480, 420, "Spicy time",        95, 45) \
+    X("Capric",  470, 420, "Capricciosa",      100, 45) \
+    X("4Formag", 460, 410, "Quattro Formaggi", 100, 45) \
+    X("Bianca",  470, 420, "Pizza Bianca",      90, 45) \
+    X("Calzone", 430, 400, "Calzone ready",    150, 55) \
+    X("Chilled", 500, 370, "Chilled pizza",     90, 40) \
+    X("Frozen",  300, 280, "Frozen pizza",     420, 55) \
+    X("Reheat",  280, 260, "Reheat slices",    180, 55) \
+    X("Pinsa",   320, 300, "Pinsa Romana",     300, 60) \
+    X("Pala",    360, 330, "Pizza in pala",    240, 55) \
+    X("Teglia",  300, 290, "Pizza in teglia",  420, 70) \
+    X("NewYork", 330, 300, "NY style",         420, 60) \
+    X("NeoNY",   370, 340, "Neo-NY",           300, 55) \
+    X("NewHavn", 350, 330, "Apizza",           480, 55) \
+    X("Tavern",  300, 290, "Bar pie",          600, 65) \
+    X("StLouis", 270, 260, "St. Louis",        600, 60) \
+    X("Detroit", 290, 280, "Detroit style",    900, 75) \
+    X("Grandma", 280, 270, "Grandma pie",      780, 70) \
+    X("Sicilia", 280, 270, "Sfincione",        900, 70) \
+    X("Chicago", 240, 230, "Deep dish",       1800, 75) \
+    X("Calif",   400, 370, "California",       240, 50) \
+    X("Flammku", 380, 350, "Flammkuchen",      240, 55) \
+    X("Pissal",  260, 250, "Pissaladiere",    1200, 65) \
+    X("Coca",    300, 280, "Coca",             600, 60) \
+    X("Focacc",  260, 250, "Focaccia",        1200, 70) \
+    X("Genoves", 250, 240, "Genovese",        1200, 70) \
+    X("Barese",  280, 270, "Focaccia barese",  900, 70) \
+    X("Fugazza", 300, 280, "Fugazza",          900, 65) \
+    X("Faina",   330, 310, "Faina",            600, 65) \
+    X("Farinat", 330, 310, "Farinata",         600, 65) \
+    X("Piadina", 250, 260, "Piadina",          180, 75) \
+    X("Naan",    420, 400, "Naan",              90, 60) \
+    X("Kulcha",  400, 380, "Kulcha",           120, 60) \
+    X("Roti",    350, 350, "Roti",              60, 70) \
+    X("Pita",    430, 400, "Pita puffed",      120, 60) \
+    X("Lavash",  400, 380, "Lavash",            60, 60) \
+    X("Sangak",  430, 410, "Sangak",           240, 65) \
+    X("Barbari", 400, 380, "Barbari",          360, 60) \
+    X("Lahmacu", 420, 380, "Lahmacun",         150, 55) \
+    X("Pide",    380, 360, "Pide",             300, 60) \
+    X("Manakis", 400, 380, "Manakish",         150, 60) \
+    X("Khachap", 330, 310, "Khachapuri",       600, 60) \
+    X("Ciabatt", 250, 240, "Ciabatta",        1500, 65) \
+    X("Sourdgh", 250, 250, "Sourdough",       2400, 70) \
+    X("Grissin", 220, 210, "Grissini",         900, 60) \
+    X("Garlic",  300, 260, "Garlic bread",     300, 40) \
+    X("Crostin", 280, 250, "Crostini",         240, 40) \
+    X("Roast",   350, 300, "Roast veg",        600, 40) \
+    X("Nutella", 350, 300, "Dolce!",           120, 50) \
+    X("Smores",  300, 250, "S'mores",          120, 30)
+
+#define EL_PICO_RECIPE_ROW(n, u, l, m, b, p) { n, u, l, m, b, p },
+#define EL_PICO_RECIPE_CHECK(n, u, l, m, b, p) \
+    static_assert(u < Hard::PLATE_MAX_C && l < Hard::PLATE_MAX_C && p <= 100 && b > 0 && b <= Hard::BAKE_SEC_MAX, "invalid recipe: " n);
+    EL_PICO_RECIPES(EL_PICO_RECIPE_CHECK)
+    const Recipe recipes[] PROGMEM = { EL_PICO_RECIPES(EL_PICO_RECIPE_ROW) };
+#undef EL_PICO_RECIPE_ROW
+#undef EL_PICO_RECIPE_CHECK
     constexpr uint8_t RECIPE_CNT = sizeof(recipes) / sizeof(Recipe);
+    static_assert(sizeof(recipes) / sizeof(Recipe) < 0xFF, "recipe index 0xFF is reserved");
+
+    // ユーザーが調整したレシピ値を保持するEEPROM領域（Settingsの拡張と干渉しない固定位置）
+    constexpr int     RECIPE_OVERLAY_ADDR  = 512;
+    constexpr uint8_t RECIPE_OVERLAY_SLOTS = 8;
+    // ヒーター素線の寿命記録（素線の状態なので、設定の初期化やファクトリーリセットでは消さない）
+    constexpr int     LIFE_ADDR            = 600;
 
     struct Limit { char label[6]; float watts; };
     const Limit limits[] PROGMEM = {
@@ -79,6 +236,115 @@ namespace Config {
         {"0.7kW",  700.0f}
     };
     constexpr uint8_t LIMIT_CNT = sizeof(limits) / sizeof(Limit);
+
+    // [ヒーター寿命] 素線の酸化をアレニウス則で積算し、熱サイクルによる疲労を加えて寿命を見積もる
+    // 基準温度で連続使用した場合の寿命を1とし、温度に応じた速度 exp(EA_K·(1/Tref − 1/T)) で消費する
+    namespace Life {
+        constexpr float   REF_C         = Hard::HEATER_MAX_C; // 基準温度
+        constexpr float   REF_LIFE_H    = 2000.0f;  // 基準温度で連続使用した場合の寿命 [h]
+        constexpr float   EA_K          = 17400.0f; // 活性化エネルギー/ボルツマン定数 [K]（約1.5eV、基準付近で約50℃ごとに速度2倍）
+        constexpr float   CYCLE_HI_C    = 500.0f;   // 熱サイクル: この温度を超えた後、
+        constexpr float   CYCLE_LO_C    = 150.0f;   //   この温度を下回ったら1回
+        constexpr float   CYCLE_LIFE    = 10000.0f; // 熱サイクルだけで寿命に達する回数
+        constexpr float   ACTIVE_C      = 200.0f;   // 稼働時間として数える素線温度
+        constexpr float   MIN_ACTIVE_H  = 1.0f;     // これ未満の稼働実績では上限温度での連続使用として見積もる
+        constexpr float   WEAR_DERATE_C = 60.0f;    // 消耗に応じた素線温度上限の引き下げ幅（寿命末期で最大）
+        constexpr float   CAP_BAND_C    = 20.0f;    // 素線温度が上限をこの幅だけ超えると出力0
+        constexpr float   MAINT_H       = 50.0f;    // 残り寿命がこれを下回ったら交換を促す
+        constexpr uint8_t MAGIC         = 0xB7;
+    }
+
+    // [残差診断] 素線・プレートの1秒ごとの温度変化を、直前1秒間の印加出力からモデルで予測した変化と比べ、
+    // 持続的なずれを片側CUSUMで検出して故障を切り分ける（素線モデル dTh/dt = a·u - b·(Th - Tp) は運転中に学習）
+    //   指令OFF中に素線が予測より熱くなる + プレートは遅れていない → SSRの短絡（部分的な導通を含む）
+    //   素線が予測より熱くなる + プレートが遅れる       → プレートの熱電対の脱落（基準が下がって見える）
+    //   素線が通電無しでも説明できないほど冷える       → 素線の熱電対の脱落
+    //   素線が通電無しと同じように冷える               → 素線の断線
+    // 素線側は等価デューティー（予測外の加熱/a）、プレート側は温度 [℃] で累積する
+    namespace Residual {
+        constexpr float   WIRE_A      = 6.0f;   // 素線モデルの初期値 a [℃/s]
+        constexpr float   WIRE_B      = 0.04f;  //                  b [1/s]
+        constexpr float   WIRE_A_MIN  = 2.0f,  WIRE_A_MAX = 50.0f; // 学習範囲（ノイズで縮退させない）
+        constexpr float   WIRE_B_MIN  = 0.01f, WIRE_B_MAX = 0.5f;
+        constexpr float   WIRE_P0A    = 0.05f;  // 初期値の確からしさ（共分散、小さいほど1標本で動かない）
+        constexpr float   WIRE_P0B    = 1.0e-4f;  // 忘却はせず起動後の全標本で最小二乗（定常状態で発散しない）
+        constexpr float   K_WIRE      = 0.25f;  // 素線残差の許容（モデル誤差・電圧変動の分）
+        constexpr float   H_WIRE      = 2.0f;   // 素線残差の判定閾値（全導通で約3秒、半導通で約8秒）
+        constexpr uint8_t OPEN_X      = 3;      // 断線は H_WIRE のこの倍数で判定（熱電対の脱落と見分ける猶予）
+        constexpr float   K_PLATE_C   = 0.3f;   // プレート残差の許容 [℃/s]
+        constexpr float   H_LAG_C     = 8.0f;   // 素線が熱い時、プレートの遅れがこれ以下なら短絡、超えれば脱落 [℃]
+        constexpr uint8_t ARM_S       = 60;     // 素線モデルの学習に使う加熱時間 [s]（それまでは判定しない。暴走は温度監視で止まる）
+        constexpr float   U_OFF       = 0.02f;  // 短絡の判定は指令出力がこれ未満の時だけ（通電中の予測外の加熱は熱容量の誤差と区別できない）
+        constexpr uint8_t OFF_S       = 2;      // 指令OFFがこの秒数続いてから判定（素線の熱電対の遅れの分）
+    }
+
+    // [投入検知] 下火の生温度（中央値）の1秒差分に対する片側CUSUM
+    // 検出対象の下降速度 STEP_C に対しドリフト k = STEP_C/2、閾値 h = σ²·ln(ARL)/(2k) とする
+    // （Siegmund近似で誤報の平均間隔 ≈ ARL秒、検出遅れの目安 ≈ h/(STEP_C-k) + 1秒）
+    namespace Load {
+        constexpr float STEP_C    = 4.0f;   // 投入時に想定する下火の下降速度 [℃/s]
+        constexpr float NOISE_C   = 0.75f;  // 無負荷時の1秒差分の標準偏差 [℃]
+        constexpr float LN_ARL    = 10.5f;  // ln(誤報の平均間隔[s])、10.5で約10時間に1回
+        constexpr float DRIFT_C   = STEP_C / 2.0f;
+        constexpr float THRESH_C  = NOISE_C * NOISE_C * LN_ARL / (2.0f * DRIFT_C);
+        // [取り出し検知] 投入後、熱負荷が抜けて下火が上昇に転じたことを同様に検出
+        constexpr float UNLOAD_STEP_C   = 2.0f;
+        constexpr float UNLOAD_DRIFT_C  = UNLOAD_STEP_C / 2.0f;
+        constexpr float UNLOAD_THRESH_C = NOISE_C * NOISE_C * LN_ARL / (2.0f * UNLOAD_DRIFT_C);
+        constexpr uint16_t MIN_DWELL_S  = 30;   // 投入からこの時間は取り出しと判定しない
+    }
+
+    // [トレンド表示] 各ゾーンの表面温度を一定間隔で記録し、レシピ温度を基準にした帯グラフで描く
+    // バッファレスのU8x8で転送量を抑えるため、スクロールせず掃引カーソルで上書きする（オシロスコープ式）
+    namespace Trend {
+        constexpr uint8_t SAMPLE_S = 4;    // 記録間隔 [s]
+        constexpr uint8_t COLS     = 96;   // 記録数 = グラフ幅 [px]（右端4文字は数値表示）
+        constexpr uint8_t C_PER_PX = 3;    // 縦1pxあたりの温度 [℃]（記録の分解能も同じ、最大765℃）
+        constexpr uint8_t ABOVE_C  = 18;   // 帯の上端（レシピ温度からの高さ）[℃]
+        constexpr uint8_t GAP      = 2;    // 掃引カーソル前方の消去幅 [px]
+        constexpr uint8_t SLOPE_S  = 60;   // 傾きの算出区間 [s]
+        constexpr uint8_t ROWS     = 6;    // グラフに使う行（1-6行目）
+        static_assert(COLS % 8 == 0 && COLS <= 96, "graph must leave 4 text columns");
+        static_assert(SLOPE_S % SAMPLE_S == 0 && SLOPE_S / SAMPLE_S < COLS - GAP, "slope window must fit in the ring");
+        static_assert(255 * C_PER_PX > Hard::PLATE_MAX_C, "record range must cover PLATE_MAX_C");
+    }
+
+    // [電流計測] 主電源の電流センサー（RMS-DC変換出力のCTモジュール）から各ゾーンのフル出力時の
+    // 電流を推定し、電力枠を定格ではなく実電流で管理する（電力は 電流×公称電圧 で換算）
+    // SSRの組み合わせが SETTLE_MS 以上変わらない区間のサンプルだけで I = 基底 + Σ g·on を正規化LMSで学習する
+    namespace Mains {
+        constexpr bool     SENSOR      = false;            // センサー実装時にtrue（falseなら従来どおり定格で配分）
+        constexpr float    VOLTS       = 100.0f;           // 公称電圧（電力枠[W]と電流の換算）
+        constexpr float    A_PER_LSB   = 30.0f / 1023.0f;  // ADC 1LSBあたりの電流 [A]（30A/5Vのモジュール）
+        constexpr uint16_t SETTLE_MS   = 100;              // SSR切替後、センサー出力が落ち着くまでの時間（変換の時定数の3倍以上）
+        constexpr float    MU          = 0.01f;            // 学習ゲイン（100Hzで約1秒分のON区間で収束）
+        constexpr uint16_t MIN_SAMPLES = 300;              // ON区間のサンプルがこれ未満のゾーンは定格で配分
+        constexpr float    MIN_RATIO   = 0.75f;            // 定格に対する推定値の許容範囲（外れたらセンサー異常として
+        constexpr float    MAX_RATIO   = 1.25f;            //   全ゾーンを定格で配分）
+        constexpr float    BASE_MAX_A  = 1.0f;             // SSR全OFF時の電流の上限（超えたらセンサー異常）
+    }
+
+    // 同一回路で複数台を運用する際の電力協調（Serial1で接続、マスターが配分）
+    // 2台は TX/RX をクロス接続、3台以上は自動方向切替のRS-485モジュールでバス接続する
+    namespace Link {
+        constexpr uint8_t  ROLE_STANDALONE = 0, ROLE_MASTER = 1, ROLE_SLAVE = 2;
+        constexpr uint8_t  ROLE       = ROLE_STANDALONE;
+        constexpr uint8_t  OVEN_ID    = 1;        // スレーブのID（1..PEER_CNT）
+        constexpr uint8_t  PEER_CNT   = 1;        // マスター以外の台数
+        constexpr uint32_t BAUD       = 19200UL;
+        constexpr float    SHARED_W   = 1420.0f;  // 回路全体の上限
+        constexpr float    FAILSAFE_W = 700.0f;   // リンク断時に各台が守る上限
+        constexpr uint32_t TIMEOUT_MS = 3000UL;   // 受信途絶でフェイルセーフへ移行
+        static_assert(FAILSAFE_W * (PEER_CNT + 1) <= SHARED_W, "FAILSAFE_W x units must fit in SHARED_W");
+    }
+}
+
+namespace DisplayPage {
+    constexpr uint8_t MAIN = 0;
+    constexpr uint8_t STATS = 1;
+    constexpr uint8_t DIAG = 2;
+    constexpr uint8_t TREND = 3;
+    constexpr uint8_t COUNT = 4;
 }
 
 namespace AskConfirmation {
@@ -88,38 +354,357 @@ namespace AskConfirmation {
     constexpr uint8_t FACTORY_RESET = 3;
 }
 
+/* ================= CYCLE PROBE ================= */
+// -DEL_PICO_CYCLES でビルドすると、計測区間の入口でGPIOR1、出口でGPIOR2に区間番号を書き込む。
+// AVRシミュレーター（host/avrcycles.cpp）がこの書き込みを捕まえて区間ごとのサイクル数を数える
+// （書き込み1回につき1サイクル。通常のビルドでは何も生成しない）
+namespace CycleProbe {
+    enum Id : uint8_t { LOOP = 1, TICK, POWER, OLED, TELEM }; // host/avrcycles.cpp の NAMES と同じ順
+#if defined(__AVR__) && defined(EL_PICO_CYCLES)
+    struct Scope {
+        explicit Scope(uint8_t id) : _id(id) { GPIOR1 = id; }
+        ~Scope() { GPIOR2 = _id; }
+        uint8_t _id;
+    };
+#else
+    struct Scope { explicit Scope(uint8_t) {} };
+#endif
+}
+#define CYCLE_PROBE(id) CycleProbe::Scope cycleProbe_(CycleProbe::id)
+
+/* ================= THERMAL MODEL ================= */
+// プレート温度の一次遅れモデル dT/dt = a·u - b·(T - 室温)（u: 印加出力 0..1）
+// 忘却係数付き逐次最小二乗法(RLS)で運転中に a, b を学習する
+// 素線温度のモデル（基準をプレート温度とする）にも同じ形で使う
+class ThermalModel {
+public:
+    // 学習の設定（物理的にあり得る範囲、共分散の初期値＝上限、忘却係数）
+    struct Limits { float aMin, aMax, bMin, bMax, p0a, p0b, lambda; };
+    static const Limits PLATE, WIRE;
+
+    float a, b;
+
+    ThermalModel(float a0, float b0, const Limits &lim = PLATE)
+        : a(a0), b(b0), _lim(&lim), _p00(lim.p0a), _p11(lim.p0b) {}
+
+    // 温度 T、基準温度 ref で出力 u を印加した場合の変化速度 [℃/s]
+    float rate(float T, float u, float ref = Config::Hard::AMBIENT_C) const { return a * u - b * (T - ref); }
+
+    // 1秒間の温度変化 dT と、その間の印加出力 u から学習
+    void learn(float T, float dT, float u, float ref = Config::Hard::AMBIENT_C) {
+        const float LAMBDA = _lim->lambda;
+        float p0 = u, p1 = -(T - ref);
+        float q0 = _p00 * p0 + _p01 * p1, q1 = _p01 * p0 + _p11 * p1;
+        float den = LAMBDA + p0 * q0 + p1 * q1;
+        float k0 = q0 / den, k1 = q1 / den;
+        float e = dT - (a * p0 + b * p1);
+        a += k0 * e; b += k1 * e;
+        _p00 = (_p00 - k0 * q0) / LAMBDA;
+        _p01 = (_p01 - k0 * q1) / LAMBDA;
+        _p11 = (_p11 - k1 * q1) / LAMBDA;
+        // 励起が無い間の共分散の発散を防止し（対角は上限まで、非対角は正定値を保つ範囲まで）、物理的にあり得る範囲に制限
+        // （非対角が残ると、室温で放置した間に den が負になり a/b が振れてNaNに至る）
+        _p00 = constrain(_p00, 0.0f, _lim->p0a);
+        _p11 = constrain(_p11, 0.0f, _lim->p0b);
+        float pm = sqrtf(_p00 * _p11);
+        _p01 = constrain(_p01, -pm, pm);
+        a = constrain(a, _lim->aMin, _lim->aMax);
+        b = constrain(b, _lim->bMin, _lim->bMax);
+    }
+
+    // 出力 u を続けた場合の到達温度
+    float steadyC(float u) const { return Config::Hard::AMBIENT_C + a * u / b; }
+
+    // from から to まで出力 u で加熱するのに要する秒数（到達不能なら大きな値）
+    float secondsTo(float from, float to, float u) const {
+        if (from >= to) return 0.0f;
+        float inf = steadyC(u);
+        if (inf <= to) return 1.0e6f;
+        return logf((inf - from) / (inf - to)) / b;
+    }
+
+    // from から to へちょうど sec 秒で到達する一定出力（到達済みなら to を保つ出力）
+    // exp(-b·sec) の形で計算し、長い予約（b·sec が大きい）でも溢れずに保持出力へ近づける
+    float powerFor(float from, float to, float sec) const {
+        float x = to - Config::Hard::AMBIENT_C;
+        float hold = b * x / a;
+        if (from >= to) return hold;
+        float e = expf(-b * ((sec > 1.0f) ? sec : 1.0f));
+        float u = b / a * (x - (from - Config::Hard::AMBIENT_C) * e) / (1.0f - e);
+        return isfinite(u) ? u : hold;
+    }
+
+    // 出力 u で sec 秒以内に to へ到達できる最低の開始温度
+    float startFor(float to, float sec, float u) const {
+        float inf = steadyC(u);
+        if (inf <= to) return to;
+        float t0 = inf - (inf - to) * expf(b * sec);
+        return (t0 < Config::Hard::AMBIENT_C) ? Config::Hard::AMBIENT_C : t0;
+    }
+
+private:
+    const Limits *_lim;
+    float _p00, _p01 = 0.0f, _p11;
+};
+
+const ThermalModel::Limits ThermalModel::PLATE = { 0.05f, 10.0f, 0.0002f, 0.05f, 1.0f, 1.0e-6f, 0.998f };
+const ThermalModel::Limits ThermalModel::WIRE = {
+    Config::Residual::WIRE_A_MIN, Config::Residual::WIRE_A_MAX,
+    Config::Residual::WIRE_B_MIN, Config::Residual::WIRE_B_MAX,
+    Config::Residual::WIRE_P0A, Config::Residual::WIRE_P0B, 1.0f
+};
+
+/* ================= HEATER LIFE ================= */
+// 素線の消耗を寿命に対する割合（2^32で寿命）として積算する
+class HeaterLife {
+public:
+    static constexpr float UNIT = 4294967296.0f;
+    uint32_t wear = 0;     // 消費した寿命
+    uint16_t cycles = 0;   // 熱サイクル数
+    uint32_t activeS = 0;  // 稼働時間 [s]
+
+#pragma pack(push, 1)
+    struct Record { uint16_t wear, cycles, hours10; }; // EEPROM保存形式（wearは上位16bit、稼働時間は0.1h単位）
+#pragma pack(pop)
+
+    // 1秒ごとに素線温度を渡す。保存すべき変化（0.1%以上の消耗、熱サイクル完了）があればtrue
+    bool tick(float heaterC) {
+        if (heaterC > Config::Life::ACTIVE_C) activeS++;
+        float inc = _frac + rate(heaterC) * (UNIT / (Config::Life::REF_LIFE_H * 3600.0f));
+        bool cycled = false;
+        if (!_hot && heaterC > Config::Life::CYCLE_HI_C) {
+            _hot = true;
+        } else if (_hot && heaterC < Config::Life::CYCLE_LO_C) {
+            _hot = false; cycles++; cycled = true;
+            inc += UNIT / Config::Life::CYCLE_LIFE;
+        }
+        uint32_t n = static_cast<uint32_t>(inc);
+        _frac = inc - n;
+        wear = (wear > 0xFFFFFFFFUL - n) ? 0xFFFFFFFFUL : wear + n;
+        return cycled || (wear >> 16) - _savedHi >= 66; // 66/65536 ≒ 0.1%
+    }
+
+    float fraction() const { return wear / UNIT; }
+
+    // 基準温度に対する消耗速度
+    static float rate(float c) {
+        return exp(Config::Life::EA_K * (1.0f / (Config::Life::REF_C + 273.15f) - 1.0f / (c + 273.15f)));
+    }
+
+    // 残り寿命 [h]：これまでの平均消耗速度で外挿（実績が少ない間は素線温度上限で使い続けた場合）
+    float remainingH(float capC) const {
+        float used = fraction(), hours = activeS / 3600.0f;
+        if (used >= 1.0f) return 0.0f;
+        if (hours >= Config::Life::MIN_ACTIVE_H && used > 0.0f) return (1.0f - used) * hours / used;
+        return (1.0f - used) * Config::Life::REF_LIFE_H / rate(capC);
+    }
+
+    // 消耗した素線は細って同じ電力でも高温になりやすいため、上限を下げて労わる
+    float capC(float setC) const { return setC - Config::Life::WEAR_DERATE_C * fraction(); }
+
+    // 交換時などに消耗度[%]を設定（0で稼働実績もリセット）
+    void setPercent(float pct) {
+        wear = (pct >= 100.0f) ? 0xFFFFFFFFUL : static_cast<uint32_t>(pct / 100.0f * UNIT);
+        if (pct <= 0.0f) { cycles = 0; activeS = 0; }
+        _frac = 0;
+    }
+
+    Record record() const {
+        uint32_t h10 = activeS / 360UL;
+        return { static_cast<uint16_t>(wear >> 16), cycles, static_cast<uint16_t>(min(h10, 0xFFFFUL)) };
+    }
+    void restore(const Record &r) {
+        wear = static_cast<uint32_t>(r.wear) << 16; cycles = r.cycles; activeS = r.hours10 * 360UL;
+        _savedHi = r.wear;
+    }
+    void markSaved() { _savedHi = wear >> 16; }
+
+private:
+    float _frac = 0;       // 1単位未満の端数
+    uint16_t _savedHi = 0; // 保存済みのwear上位16bit
+    bool _hot = false;
+};
+
+/* ================= THERMOCOUPLE DRIVERS ================= */
+// 品種ごとの特殊化を Config::Thermo::CHIP でコンパイル時に選ぶ（仮想呼び出しを使わない）
+// read() は温度[℃]を返す。異常時はNaNを返し、faultに Config::Thermo::Fault のビットを立てる
+namespace ThermoBus {
+    // CSを下げてnバイトを送受信（bufの内容を送り、受信値で上書き）
+    void transfer(uint8_t cs, uint8_t mode, uint8_t *buf, uint8_t n) {
+        SPI.beginTransaction(SPISettings(4000000UL, MSBFIRST, mode)); // MAX6675の上限4.3MHz以下
+        digitalWrite(cs, LOW);
+        for (uint8_t i = 0; i < n; i++) buf[i] = SPI.transfer(buf[i]);
+        digitalWrite(cs, HIGH);
+        SPI.endTransaction();
+    }
+}
+
+template <uint8_t CHIP> class Thermocouple;
+
+// MAX6675: 0.25℃、0〜1023.75℃、断線検出のみ。CSを上げると変換開始（読み出しで中断）
+template <> class Thermocouple<Config::Thermo::MAX6675> {
+public:
+    static constexpr uint16_t CONV_MS = 220;
+    static constexpr float RANGE_MAX_C = 1023.75f;
+
+    explicit Thermocouple(uint8_t cs) : _cs(cs) { pinMode(_cs, OUTPUT); digitalWrite(_cs, HIGH); }
+
+    float read(uint8_t &fault) {
+        uint8_t b[2] = { 0, 0 };
+        ThermoBus::transfer(_cs, SPI_MODE0, b, 2);
+        uint16_t v = (static_cast<uint16_t>(b[0]) << 8) | b[1];
+        fault = (v & 0x8002) ? Config::Thermo::F_BUS   // D15(ダミー)とD1(ID)は常に0
+              : (v & 0x0004) ? Config::Thermo::F_OPEN : 0;
+        return fault ? NAN : (v >> 3) * 0.25f;
+    }
+
+private:
+    uint8_t _cs;
+};
+
+// MAX31855: 0.25℃、-270〜1800℃、断線/GND短絡/VCC短絡を検出。変換はMAX6675と同じ方式
+template <> class Thermocouple<Config::Thermo::MAX31855> {
+public:
+    static constexpr uint16_t CONV_MS = 100;
+    static constexpr float RANGE_MAX_C = 1372.0f; // K型の上限
+
+    explicit Thermocouple(uint8_t cs) : _cs(cs) { pinMode(_cs, OUTPUT); digitalWrite(_cs, HIGH); }
+
+    float read(uint8_t &fault) {
+        uint8_t b[4] = { 0, 0, 0, 0 };
+        ThermoBus::transfer(_cs, SPI_MODE0, b, 4);
+        uint32_t v = (static_cast<uint32_t>(b[0]) << 24) | (static_cast<uint32_t>(b[1]) << 16) |
+                     (static_cast<uint32_t>(b[2]) << 8) | b[3];
+        if (v & 0x00020008UL) { fault = Config::Thermo::F_BUS; return NAN; } // D17/D3は予約（常に0）
+        fault = 0;
+        if (v & 0x00010000UL) {
+            if (v & 1) fault |= Config::Thermo::F_OPEN;
+            if (v & 6) fault |= Config::Thermo::F_SHORT;
+            return NAN;
+        }
+        return (static_cast<int32_t>(v) >> 18) * 0.25f;
+    }
+
+private:
+    uint8_t _cs;
+};
+
+// MAX31856: 1/128℃、断線/過電圧(短絡)/範囲外/冷接点異常を検出。連続変換モードで使う
+// 電源瞬断で設定が消えると変換が止まるため、毎回CR0を読み返して再設定する
+template <> class Thermocouple<Config::Thermo::MAX31856> {
+public:
+    static constexpr uint16_t CONV_MS = 100; // 連続変換・50Hzフィルタ・平均1回
+    static constexpr float RANGE_MAX_C = 1372.0f;
+
+    explicit Thermocouple(uint8_t cs) : _cs(cs) { pinMode(_cs, OUTPUT); digitalWrite(_cs, HIGH); }
+
+    float read(uint8_t &fault) {
+        uint8_t b[17] = { 0x00 }; // CR0からSRまで（0x00〜0x0F）を連続読み出し
+        ThermoBus::transfer(_cs, SPI_MODE1, b, sizeof(b));
+        fault = 0;
+        if (b[16] == 0xFF) { fault = Config::Thermo::F_BUS; return NAN; } // MISO固着（全異常が同時に立つことはない）
+        if (b[1] != CR0 || b[2] != CR1) {
+            configure();
+            return NAN; // 最初の変換が終わるまでは無効
+        }
+        if (millis() - _configMs < CONV_MS) return NAN;
+        uint8_t sr = b[16];
+        if (sr & 0x01) fault |= Config::Thermo::F_OPEN;
+        if (sr & 0x02) fault |= Config::Thermo::F_SHORT;
+        if (sr & 0xFC) fault |= Config::Thermo::F_RANGE;
+        if (fault) return NAN;
+        int32_t t = static_cast<int32_t>((static_cast<uint32_t>(b[13]) << 24) | (static_cast<uint32_t>(b[14]) << 16) |
+                                         (static_cast<uint32_t>(b[15]) << 8)) >> 13; // 19bit符号付き
+        return t / 128.0f;
+    }
+
+private:
+    static constexpr uint8_t CR0 = 0x91; // 連続変換 | 断線検出(OCFAULT=01) | 50Hz除去
+    static constexpr uint8_t CR1 = 0x03; // 平均1回 | K型
+
+    void configure() {
+        uint8_t b[3] = { 0x80, CR0, CR1 }; // 0x80: CR0への書き込み（自動インクリメント）
+        ThermoBus::transfer(_cs, SPI_MODE1, b, sizeof(b));
+        _configMs = millis();
+    }
+
+    uint8_t _cs;
+    uint32_t _configMs = 0;
+};
+
+using TcSensor = Thermocouple<Config::Thermo::CHIP>;
+
 /* ================= HEATER CONTROL CLASS ================= */
 // 1つのヒーターユニット（プレート+ヒーターの2個のセンサー）を管理するクラス
 class IntelligentHeater {
 public:
     float plateC = 0, heaterC = 0, soak = 0, trend = 0;
-    uint8_t pwm = 0, error = 0; // error bit: 0:Sensor, 1:Runaway, 2:Overheat
-
-    IntelligentHeater(uint8_t csP, uint8_t csH, uint8_t ssr)
-        : _plate(Config::Pins::THERMO_CLK, csP, Config::Pins::THERMO_DO),
-          _heater(Config::Pins::THERMO_CLK, csH, Config::Pins::THERMO_DO),
+    float rawPlateC = 0, rawHeaterC = 0; // フィルタ前の中央値
+    uint8_t pwm = 0, error = 0; // error bit: 0:Sensor, 1:Runaway, 2:Overheat, 3:SSR短絡, 4:素線断線, 5:熱電対脱落
+    uint8_t detachedTc = 0;     // 脱落と判定した熱電対（bit0:プレート bit1:ヒーター）
+    uint16_t rejects = 0;       // 棄却したサンプル数（ノイズ監視用）
+    uint8_t tcFault = 0;        // 有効値が途絶えてからアンプが報告した異常（下位4bit:プレート 上位4bit:ヒーター）
+    static constexpr uint32_t SAMPLE_MS = TcSensor::CONV_MS + Config::Hard::SAMPLE_MARGIN_MS;
+    // 断線からセンサーエラー確定までの最悪値（最後の有効な周期は中央値が無効になる直前まで遅れうる）
+    static constexpr uint32_t TRIP_MAX_MS = (Config::Hard::SAMPLE_RING / 2 + 1) * SAMPLE_MS +
+                                            (Config::Hard::SENSOR_PERSIST_MS / 1000UL + 1UL) * 1000UL;
+    ThermalModel model;         // 学習済みの熱モデル
+    ThermalModel wire;          // 素線温度のモデル（残差診断用、起動ごとに学習）
+    HeaterLife life;            // 素線の消耗
+
+    IntelligentHeater(uint8_t csP, uint8_t csH, uint8_t ssr, float modelA, float modelB)
+        : model(modelA, modelB),
+          wire(Config::Residual::WIRE_A, Config::Residual::WIRE_B, ThermalModel::WIRE),
+          _plate(csP), _heater(csH),
           _ssr(ssr) {
         pinMode(_ssr, OUTPUT);
-        digitalWrite(_ssr, LOW);
+        setSsr(false);
         _winStart = millis();
+        for (uint8_t i = 0; i < Config::Hard::SAMPLE_RING; i++) _ringP[i] = _ringH[i] = INVALID;
+    }
+
+    // 熱電対の連続サンプリング（loop毎に呼び出し、SAMPLE_MS間隔で取得）
+    // 欠損・アンプの異常・範囲外・物理的にあり得ない急変は無効値としてリングに格納する
+    // （短絡はMAX6675では検出できず、冷接点温度付近の正常値に見える点に注意）
+    void sample(uint32_t now) {
+        if (now - _sampleMs < SAMPLE_MS) return;
+        _sampleMs = now;
+        float ageS = (now - _lastGoodMs) / 1000.0f + 2.0f; // 最後の有効値からの経過（中央値の遅れ分を含む）
+        uint8_t fP, fH;
+        float p = _plate.read(fP), h = _heater.read(fH);
+        tcFault |= fP | (fH << 4);
+        _ringP[_ringIdx] = validate(p, rawPlateC, TcSensor::RANGE_MAX_C,
+                                    Config::Hard::PLATE_RATE_MAX_C * ageS);
+        _ringH[_ringIdx] = validate(h, rawHeaterC, Config::Hard::HEATER_MAX_C + 100.0f,
+                                    Config::Hard::HEATER_RATE_MAX_C * ageS);
+        _ringIdx = (_ringIdx + 1) % Config::Hard::SAMPLE_RING;
     }
 
     // 制御サイクルの実行（毎秒呼び出し）
     // インライン展開を防ぎFlashを節約
-    bool tick(float target, float &health) __attribute__((noinline)) {
-        float rp = _plate.readCelsius(), rh = _heater.readCelsius();
+    // capC: 素線温度の上限（消耗に応じてさらに引き下げる）。寿命記録を保存すべき時にtrueを返す
+    bool tick(float target, float capC, float outMax = 255.0f) __attribute__((noinline)) {
+        CYCLE_PROBE(TICK);
+        float rp, rh;
+        uint32_t now = millis();
 
-        // [異常検知] センサーエラー時は即座にPWMを0にし、SSRを物理的に停止
-        if (isnan(rp) || rp < 0.0f || rp > Config::Hard::PLATE_MAX_C || // プレートセンサーの異常値
-            isnan(rh) || rh < 0.0f || rh > Config::Hard::HEATER_MAX_C + 100.0f) { // ヒーターセンサーの異常値
-            error |= 1; pwm = 0; _out = 0; digitalWrite(_ssr, LOW); return false;
+        // [異常検知] 有効サンプルが過半数に満たない間はこのゾーンの出力を止めて様子を見る
+        // 途絶が SENSOR_PERSIST_MS 続いた場合のみセンサーエラーを確定する
+        if (!median(_ringP, rp) || !median(_ringH, rh)) {
+            pwm = 0; _out = 0; setSsr(false);
+            if (now - _lastGoodMs > Config::Hard::SENSOR_PERSIST_MS) error |= 1;
+            _resPrimed = false; // 欠損をまたいだ差分は使わない
+            return false;
         }
+        _lastGoodMs = now;
         error &= ~1;
+        tcFault = 0;
+        rawPlateC = rp; rawHeaterC = rh;
         heaterC = rh;
 
         // 初回起動時の温度追従
         if (_first) { 
-            plateC = rp; _first = false; _runawayMs = millis(); 
+            plateC = rp; _first = false; _runawayMs = now; 
             _lastInput = plateC;
         }
 
@@ -128,6 +713,11 @@ public:
         plateC = 0.8f * plateC + 0.2f * rp;
         trend = 0.9f * trend + 0.1f * (plateC - prev); // 温度勾配（トレンド）を算出
 
+        // [熱モデル学習] 直前1秒間に実際に印加した出力に対する温度変化
+        float u = (_lastOut > 255) ? 0.0f : _lastOut / 255.0f;
+        model.learn(prev, plateC - prev, u);
+        diagnose(rp, rh, u);
+
         // [Soak計算] ストーンの芯まで熱が通ったかをシミュレート
         float step = 1.0f / Config::Hard::STONE_THICK_MM;
         if (target > 50.0f && f_abs(target - plateC) < 5.0f)
@@ -135,8 +725,15 @@ public:
         else
             soak = max(0.0f, soak - step * 0.5f); // 離れていれば放熱
 
+        // [目標軌道] 積分項は軌道に沿って保持出力の変化分を先回りさせる（加熱開始時は現在温度の保持出力）
+        float holdK = 255.0f * model.b / model.a;
+        float prevRef = _trajOn ? _ref : Config::Hard::AMBIENT_C;
+        // 速度の変化分は素線の遅れだけ早く出力に反映する
+        float leadV = trajectory(target) * Config::Hard::TRAJ_LAG_S;
+        _iTerm += holdK * (_ref - prevRef);
+
         _in  = plateC;
-        _set = target;
+        _set = _ref;
 
         // PID演算またはオートチューニングの実行
         if (_tuning) {
@@ -147,39 +744,38 @@ public:
         } else {
             // 簡易PID計算 (float統一でコードサイズ削減)
             float error = _set - _in;
-            _iTerm += (_ki * error);
+            if (!(_clipped && error > 0.0f)) _iTerm += (_ki * error);
             if (_iTerm > 255.0f) _iTerm = 255.0f; else if (_iTerm < 0.0f) _iTerm = 0.0f;
             
             float dInput = (_in - _lastInput);
-            float output = _kp * error + _iTerm - _kd * dInput;
+            float output = _kp * error + _iTerm - _kd * dInput + 255.0f * (_refV + leadV) / model.a; // 軌道の速度分をフィードフォワード
             
             if (output > 255.0f) output = 255.0f; else if (output < 0.0f) output = 0.0f;
+
+            // [素線温度上限] 上限を超えた分に応じて出力を絞り、積分も止める
+            float cap = life.capC(capC);
+            if (heaterC > cap) {
+                output *= max(0.0f, 1.0f - (heaterC - cap) / Config::Life::CAP_BAND_C);
+                if (_iTerm > output) _iTerm = output;
+            }
+            // [出力上限] 予約予熱の計画出力を超えない（積分も止める）
+            if (output > outMax) { output = outMax; if (_iTerm > output) _iTerm = output; }
             _out = output;
             _lastInput = _in;
         }
         pwm = static_cast<uint8_t>(_out);
 
         // [暴走検知] 出力0なのに急激に温度が上がっている場合はSSRの短絡を疑う
-        uint32_t now = millis();
         if (pwm == 0 && trend > 1.5f) {
             if (now - _runawayMs > Config::Hard::RUNAWAY_TIMEOUT_MS) error |= 2;
         } else {
             _runawayMs = now;
         }
 
-        // [健康度/過昇温管理] ヒーターフィラメントのダメージを累積計算
-        float limit = Config::Hard::HEATER_MAX_C;
-        bool damaged = false;
-        if (heaterC > limit + 40.0f) {
-            health = max(0.0f, health - 0.01f);
-            damaged = true;
-        } else if (heaterC > limit + 20.0f) {
-            health = max(0.0f, health - 0.002f);
-            damaged = true;
-        }
+        if (rp > Config::Hard::PLATE_MAX_C || plateC > Config::Hard::PLATE_MAX_C) error |= 4;
 
-        if (plateC > Config::Hard::PLATE_MAX_C) error |= 4;
-        return damaged;
+        // [寿命] 素線温度による酸化と熱サイクルを積算
+        return life.tick(heaterC);
     }
 
     // SSRのタイムプロポーショニング制御（1秒周期内でのON時間を制御）
@@ -190,19 +786,41 @@ public:
         }
         uint32_t now = millis();
         if (now - _winStart >= 1000UL) _winStart = now;
-        digitalWrite(_ssr, (now - _winStart < _onTimeMs) ? HIGH : LOW);
+        setSsr(now - _winStart < _onTimeMs);
     }
 
+    bool ssrOn() const { return _ssrOn; } // 直近に出力したSSRの状態（電流計測の振り分け用）
+
     // エラーや状態遷移時のリセット処理
     void reset() { 
         error = 0; pwm = 0; _out = 0; soak = 0; trend = 0; _overheatCnt = 0;
-        _first = true; digitalWrite(_ssr, LOW);
+        detachedTc = 0; _resPrimed = false; _gHot = _gCold = _gDrop = _gLag = _gStuck = 0; _offS = 0;
+        _first = true; setSsr(false);
         plateC = 0; heaterC = 0;
-        _runawayMs = millis(); _winStart = millis();
+        _runawayMs = _lastGoodMs = millis(); _winStart = millis();
         _iTerm = 0; _lastInput = 0; // PID内部変数のリセット
+        _ref = 0; _refV = 0; _trajOn = false;
     }
     
+    // ウォームリスタート用の制御状態（PID積分項とSoakを含む）
+    struct Snapshot { float plateC, heaterC, soak, trend, iTerm, lastInput, out; };
+    void save(Snapshot &s) const {
+        s.plateC = plateC; s.heaterC = heaterC; s.soak = soak; s.trend = trend;
+        s.iTerm = _iTerm; s.lastInput = _lastInput; s.out = _out;
+    }
+    void restore(const Snapshot &s) {
+        plateC = rawPlateC = s.plateC; heaterC = rawHeaterC = s.heaterC;
+        soak = s.soak; trend = s.trend;
+        _iTerm = s.iTerm; _lastInput = s.lastInput; _out = s.out;
+        pwm = static_cast<uint8_t>(_out);
+        _first = false; _runawayMs = _lastGoodMs = millis();
+        _ref = plateC; _refV = 0; _trajOn = true; // 積分項は復元済みのため、現在温度から軌道を続ける
+    }
+
     float pidOut() const { return _out; }
+    // 電力枠で実際に出せた出力。削られている間は積分を止める（削られた分を積み続けて到達後に行き過ぎないように。
+    // 電力換算の切り捨て分は除く）
+    void allotted(uint8_t pwm) { _clipped = pwm + 3.0f < _out; }
     void setTunings(float kp, float ki, float kd) { _kp = kp; _ki = ki; _kd = kd; }
     float getKp() { return _kp; }
     float getKi() { return _ki; }
@@ -221,51 +839,810 @@ public:
     bool isTuning() const { return _tuning; }
 
 private:
-    MAX6675 _plate, _heater;
+    void setSsr(bool on) { _ssrOn = on; digitalWrite(_ssr, on ? HIGH : LOW); }
+
+    // [目標軌道] 1秒ごとに _ref を target へ進める。速度は全出力で加熱（出力0で放熱）した場合の
+    // モデルの変化速度の TRAJ_RATE 倍（降温は TRAJ_RATE_DN 倍）まで、加速度は TRAJ_ACCEL（TRAJ_ACCEL_DN）まで。
+    // 止まれる速度に落として目標で停止する
+    // 加熱しない目標（50℃以下）はそのまま使い、加熱開始時は現在温度から始める
+    // 戻り値は加速度制限に沿った速度の変化分（加熱開始時と、先行の制限で速度を実温度に合わせた場合は0）
+    float trajectory(float target) {
+        using namespace Config::Hard;
+        if (target <= 50.0f) { _ref = target; _refV = 0.0f; _trajOn = false; return 0.0f; }
+        bool start = !_trajOn;
+        float prevV = _refV;
+        if (start) { _ref = plateC; _trajOn = true; }
+        float d = target - _ref;
+        float acc = (d > 0.0f) ? TRAJ_ACCEL : TRAJ_ACCEL_DN;
+        float vStop = sqrtf(2.0f * acc * f_abs(d));
+        float v = (d > 0.0f) ? min(vStop, max(0.0f, TRAJ_RATE * model.rate(_ref, 1.0f)))
+                             : -min(vStop, max(0.0f, -TRAJ_RATE_DN * model.rate(_ref, 0.0f)));
+        _refV = start ? v : _refV + constrain(v - _refV, -acc, acc); // 加熱開始時は素線も冷えているため全力から
+        float next = _ref + _refV;
+        if ((d > 0.0f && next >= target) || (d < 0.0f && next <= target) || d == 0.0f) { next = target; _refV = 0.0f; }
+        // 移動中に実温度が追従できない間は先行しすぎない（速度は実際に進んだ分に合わせ、
+        // 実温度の側へ引き戻された場合は全力の速度から）。到達後の投入などの外乱は従来どおりPIDに任せる
+        float lim = constrain(next, plateC - TRAJ_LEAD_C, plateC + TRAJ_LEAD_C);
+        if (next != target && lim != next) { _refV = ((lim - _ref) * d > 0.0f) ? lim - _ref : v; _ref = lim; return 0.0f; }
+        _ref = next;
+        return start ? 0.0f : _refV - prevV;
+    }
+
+    // [残差診断] 生温度（中央値）の1秒差分を直前1秒間の出力 u からの予測と比べる（Config::Residual）
+    void diagnose(float rp, float rh, float u) {
+        using namespace Config::Residual;
+        if (!_resPrimed) { _prevRp = rp; _prevRh = rh; _resPrimed = true; return; }
+        float xh = (rh - _prevRh - wire.rate(_prevRh, u, _prevRp)) / wire.a; // 素線の予測外の加熱（等価デューティー）
+        float xo = xh + u;                                                  // 同、通電が無かったとした場合
+        float ep = rp - _prevRp - model.rate(_prevRp, u);                   // プレートの予測外の変化 [℃/s]
+        _gHot  = max(0.0f, _gHot + xh - K_WIRE);
+        _offS  = (u < U_OFF) ? min(_offS + 1, 255) : 0;
+        if (_offS >= OFF_S) _gStuck = max(0.0f, _gStuck + xh - K_WIRE); // 通電中は保持
+        _gCold = max(0.0f, _gCold - xh - K_WIRE);
+        _gDrop = max(0.0f, _gDrop - xo - K_WIRE);
+        _gLag  = max(0.0f, _gLag - ep - K_PLATE_C);
+
+        // 疑いの無い間だけ素線モデルを学習（故障に追従して見逃さないように）
+        if (_gHot < H_WIRE / 2 && _gCold < H_WIRE / 2 && _gDrop < H_WIRE / 2) {
+            wire.learn(_prevRh, rh - _prevRh, u, _prevRp);
+            if (u > 0.1f && _armS < ARM_S) _armS++;
+        }
+        _prevRp = rp; _prevRh = rh;
+
+        if (_armS < ARM_S) return;
+        if (_gStuck > H_WIRE && _gLag < H_LAG_C) error |= 8;
+        if (_gHot > H_WIRE && _gLag >= H_LAG_C) { error |= 32; detachedTc |= 1; }
+        if (_gDrop > H_WIRE) { error |= 32; detachedTc |= 2; }
+        else if (_gCold > H_WIRE * OPEN_X && _gDrop < H_WIRE / 2) error |= 16;
+    }
+
+    static constexpr int16_t INVALID = -32767 - 1; // リング内の無効サンプル
+
+    static constexpr float Q = 16.0f; // リングの整数表現 [1/℃]（MAX31856の分解能は1/16℃に丸める）
+
+    // 1/16℃単位の整数に変換（無効ならINVALID）
+    int16_t validate(float c, float last, float maxC, float maxStep) {
+        if (isnan(c) || c < 0.0f || c > maxC || (!_first && f_abs(c - last) > maxStep)) {
+            rejects++;
+            return INVALID;
+        }
+        return static_cast<int16_t>(c * Q);
+    }
+
+    // 有効サンプルの中央値（有効数が過半数に満たなければfalse）
+    static bool median(const int16_t *ring, float &out) {
+        int16_t v[Config::Hard::SAMPLE_RING];
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < Config::Hard::SAMPLE_RING; i++) {
+            int16_t x = ring[i];
+            if (x == INVALID) continue;
+            uint8_t j = n++;
+            for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1]; // 挿入ソート
+            v[j] = x;
+        }
+        if (n <= Config::Hard::SAMPLE_RING / 2) return false;
+        out = ((n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0f) / Q;
+        return true;
+    }
+
+    TcSensor _plate, _heater;
+    int16_t  _ringP[Config::Hard::SAMPLE_RING], _ringH[Config::Hard::SAMPLE_RING];
+    uint8_t  _ringIdx = 0;
+    uint32_t _sampleMs = 0, _lastGoodMs = 0;
     PID_ATune* _aTune = nullptr; // メモリ節約のためポインタに戻す
     uint8_t _ssr;
+    bool    _ssrOn = false;
+    bool    _resPrimed = false;
+    uint8_t _armS = 0, _offS = 0;
+    float   _prevRp = 0, _prevRh = 0, _gHot = 0, _gCold = 0, _gDrop = 0, _gLag = 0, _gStuck = 0; // 残差診断の前回値と累積和
     float  _in, _out, _set;
     uint32_t _runawayMs = 0, _winStart = 0;
-    bool     _first = true, _tuning = false;
+    bool     _first = true, _tuning = false, _trajOn = false;
     uint8_t _overheatCnt = 0;
     uint16_t _lastOut = 256; // キャッシュ用（初期値は範囲外）
     uint32_t _onTimeMs = 0;
     float _kp = 3.5f, _ki = 0.05f, _kd = 1.0f;
     float _iTerm = 0.0f, _lastInput = 0.0f;
+    bool _clipped = false;
+    float _ref = 0.0f, _refV = 0.0f; // 目標軌道の位置と速度
+};
+
+/* ================= POWER LINK ================= */
+// 同一回路を共有する複数台の電力協調
+// マスターが各台の要求電力を集計し、回路上限(SHARED_W)を毎制御周期で再配分する。
+// フレーム: [SYNC][種別][ID][W lo][W hi][A lo][A hi][CRC8]
+//   'G' マスター→スレーブ: W=許可電力
+//   'Q' スレーブ→マスター: W=要求電力, A=現在適用中の許可電力（減少の完了確認に使用）
+class PowerLink {
+public:
+    void begin() {
+        if (Config::Link::ROLE == Config::Link::ROLE_STANDALONE) return;
+        Serial1.begin(Config::Link::BAUD);
+    }
+
+    // 受信処理とマスターのポーリング送信（loop毎に呼び出し、ブロックしない）
+    void poll(uint32_t now) {
+        using namespace Config::Link;
+        if (ROLE == ROLE_STANDALONE) return;
+        while (Serial1.available() > 0) {
+            uint8_t c = static_cast<uint8_t>(Serial1.read());
+            if (_rxLen == 0 && c != SYNC) continue; // 同期バイト待ち
+            _rx[_rxLen++] = c;
+            if (_rxLen == FRAME_LEN) {
+                _rxLen = 0;
+                if (crc8(_rx, FRAME_LEN - 1) == _rx[FRAME_LEN - 1]) onFrame(now);
+            }
+        }
+        // マスター: 半二重バスでの応答衝突を避けるため、1周期内で各スレーブへの送信を分散
+        if (ROLE == ROLE_MASTER && now - _txMs >= 1000UL / PEER_CNT) {
+            _txMs = now;
+            _pollIdx = (_pollIdx + 1) % PEER_CNT;
+            send('G', _pollIdx + 1, _peers[_pollIdx].grantW, 0);
+        }
+    }
+
+    // 自機の要求電力を渡し、今周期に使用してよい電力枠を返す（制御周期ごとに呼び出し）
+    int32_t update(uint32_t now, int32_t demandW) {
+        using namespace Config::Link;
+        _demandW = static_cast<uint16_t>(demandW);
+        if (ROLE == ROLE_STANDALONE) {
+            _appliedW = static_cast<uint16_t>(demandW);
+        } else if (ROLE == ROLE_SLAVE) {
+            _failsafe = !_heard || now - _rxMs > TIMEOUT_MS;
+            _appliedW = _failsafe ? static_cast<uint16_t>(FAILSAFE_W) : _grantW;
+        } else {
+            allocate(now, demandW);
+        }
+        return _appliedW;
+    }
+
+    uint16_t appliedW() const { return _appliedW; }
+    bool failsafe() const { return _failsafe; }
+
+private:
+    static constexpr uint8_t SYNC = 0xA5, FRAME_LEN = 8;
+    static constexpr uint8_t PEER_CNT = Config::Link::PEER_CNT;
+
+    struct Peer { uint16_t demandW, ackW, grantW; uint32_t rxMs; bool heard; };
+
+    static uint8_t crc8(const uint8_t *p, uint8_t n) {
+        uint8_t crc = 0;
+        while (n--) {
+            crc ^= *p++;
+            for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+        return crc;
+    }
+
+    void send(uint8_t type, uint8_t id, uint16_t w, uint16_t a) {
+        uint8_t f[FRAME_LEN] = { SYNC, type, id,
+            static_cast<uint8_t>(w), static_cast<uint8_t>(w >> 8),
+            static_cast<uint8_t>(a), static_cast<uint8_t>(a >> 8), 0 };
+        f[FRAME_LEN - 1] = crc8(f, FRAME_LEN - 1);
+        Serial1.write(f, FRAME_LEN);
+    }
+
+    void onFrame(uint32_t now) {
+        using namespace Config::Link;
+        uint8_t type = _rx[1], id = _rx[2];
+        uint16_t w = _rx[3] | (static_cast<uint16_t>(_rx[4]) << 8);
+        uint16_t a = _rx[5] | (static_cast<uint16_t>(_rx[6]) << 8);
+        if (ROLE == ROLE_SLAVE && type == 'G' && id == OVEN_ID) {
+            _grantW = w; _rxMs = now; _heard = true;
+            send('Q', OVEN_ID, _demandW, _appliedW); // 即時応答
+        } else if (ROLE == ROLE_MASTER && type == 'Q' && id >= 1 && id <= PEER_CNT) {
+            Peer &p = _peers[id - 1];
+            p.demandW = w; p.ackW = a; p.rxMs = now; p.heard = true;
+        }
+    }
+
+    // [配分] 通信中の台で要求の小さい順に満たす水位充填（max-min公平）
+    // スレーブへの許可を減らす場合、相手が適用を確認するまでは旧値を予約したまま扱い、
+    // 他台への増加は保留する。これにより過渡時も回路上限を超えない。
+    void allocate(uint32_t now, int32_t demandW) {
+        using namespace Config::Link;
+        int32_t pool = static_cast<int32_t>(SHARED_W);
+        int32_t demand[PEER_CNT + 1], alloc[PEER_CNT + 1];
+        bool online[PEER_CNT], settled = true, unknown = false;
+
+        demand[0] = demandW;
+        for (uint8_t i = 0; i < PEER_CNT; i++) {
+            Peer &p = _peers[i];
+            uint32_t age = now - p.rxMs;
+            online[i] = p.heard && age <= TIMEOUT_MS;
+            demand[i + 1] = online[i] ? p.demandW : 0;
+            if (online[i]) {
+                if (p.ackW > p.grantW) settled = false;
+            } else if (p.heard && age <= 2 * TIMEOUT_MS) {
+                pool -= max(p.grantW, p.ackW); // 相手がフェイルセーフへ移るまで旧許可を予約
+            } else {
+                pool -= static_cast<int32_t>(FAILSAFE_W); // 未接続の台はフェイルセーフ上限で動いている
+                if (!p.heard && now < 2 * TIMEOUT_MS) unknown = true; // 起動直後は旧許可が不明
+            }
+        }
+        if (pool < 0) pool = 0;
+
+        // 水位充填
+        uint8_t left = PEER_CNT + 1;
+        for (uint8_t i = 0; i <= PEER_CNT; i++) alloc[i] = -1;
+        for (uint8_t i = 0; i <= PEER_CNT; i++) if (i > 0 && !online[i - 1]) { alloc[i] = 0; left--; }
+        int32_t rem = pool;
+        while (left) {
+            int32_t share = rem / left;
+            bool changed = false;
+            for (uint8_t i = 0; i <= PEER_CNT; i++) {
+                if (alloc[i] < 0 && demand[i] <= share) { alloc[i] = demand[i]; rem -= demand[i]; left--; changed = true; }
+            }
+            if (!changed) {
+                for (uint8_t i = 0; i <= PEER_CNT; i++) if (alloc[i] < 0) alloc[i] = share;
+                break;
+            }
+        }
+
+        int32_t selfW = pool;
+        for (uint8_t i = 0; i < PEER_CNT; i++) {
+            Peer &p = _peers[i];
+            if (!online[i]) continue;
+            uint16_t g = static_cast<uint16_t>(alloc[i + 1]);
+            p.grantW = settled ? g : min(g, p.grantW);
+            selfW -= max(p.grantW, p.ackW);
+        }
+        selfW = min(selfW, alloc[0]);
+        if (unknown) selfW = min(selfW, static_cast<int32_t>(FAILSAFE_W));
+        _appliedW = static_cast<uint16_t>(max(selfW, 0L));
+        _failsafe = unknown;
+    }
+
+    Peer     _peers[PEER_CNT] = {};
+    uint8_t  _rx[FRAME_LEN], _rxLen = 0, _pollIdx = 0;
+    uint16_t _demandW = 0, _grantW = 0, _appliedW = 0;
+    uint32_t _rxMs = 0, _txMs = 0;
+    bool     _heard = false, _failsafe = false;
+};
+
+/* ================= MAINS METER ================= */
+// 主電源電流から各ゾーンのフル出力時の電流を推定する（Config::Mains）
+// loopごとに、直前の周期に出力していたSSRの組み合わせとともにサンプルを渡す
+class MainsMeter {
+public:
+    float baseA = 0;   // SSR全OFF時の電流（制御回路の消費とセンサーのオフセット）
+    float avgA = 0;    // 電流の移動平均（約1秒）
+
+    MainsMeter() {
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) _g[i] = Config::Zones::TABLE[i].ratedW / Config::Mains::VOLTS;
+    }
+
+    void sample(uint32_t now, uint8_t onMask) {
+        if (!Config::Mains::SENSOR) return;
+        float a = analogRead(Config::Pins::MAINS_CT) * Config::Mains::A_PER_LSB;
+        avgA += (a - avgA) * 0.01f;
+        if (onMask != _mask) { _mask = onMask; _sinceMs = now; return; }
+        if (now - _sinceMs < Config::Mains::SETTLE_MS) return;
+
+        // 正規化LMS（入力は0/1なので、ONのゾーン数+1で正規化）
+        float e = a - baseA;
+        uint8_t k = 1;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) if (onMask & (1 << i)) { e -= _g[i]; k++; }
+        float d = Config::Mains::MU * e / k;
+        baseA += d;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+            if (!(onMask & (1 << i))) continue;
+            _g[i] += d;
+            if (_n[i] < 0xFFFF) _n[i]++;
+        }
+    }
+
+    // 推定値が物理的にあり得ない（断線・ゲイン異常）
+    bool fault() const {
+        if (!Config::Mains::SENSOR) return false;
+        if (baseA > Config::Mains::BASE_MAX_A) return true;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+            float r = _g[i] * Config::Mains::VOLTS / Config::Zones::TABLE[i].ratedW;
+            if (_n[i] >= Config::Mains::MIN_SAMPLES && (r < Config::Mains::MIN_RATIO || r > Config::Mains::MAX_RATIO)) return true;
+        }
+        return false;
+    }
+
+    // ゾーンのフル出力時の電流を公称電圧で換算した電力 [W]（推定が使えなければ定格）
+    float fullW(uint8_t i) const {
+        if (!Config::Mains::SENSOR || _n[i] < Config::Mains::MIN_SAMPLES || fault()) return Config::Zones::TABLE[i].ratedW;
+        return _g[i] * Config::Mains::VOLTS;
+    }
+
+    // 配分に使う基底分 [W]
+    float baseW() const { return (Config::Mains::SENSOR && !fault()) ? baseA * Config::Mains::VOLTS : 0.0f; }
+
+private:
+    float    _g[Config::Zones::CNT];      // フル出力時の電流 [A]
+    uint16_t _n[Config::Zones::CNT] = {}; // 学習に使ったON区間のサンプル数
+    uint8_t  _mask = 0;
+    uint32_t _sinceMs = 0;
+};
+
+/* ================= ENERGY METER ================= */
+// 指令PWMと定格電力から消費電力量を積算し、1枚ごとの焼成実績を記録する
+// 1枚の区切りは「焼き開始 → 次にREADYへ復帰（または次の焼き開始）」まで
+class EnergyMeter {
+public:
+    uint32_t zoneJ[Config::Zones::CNT] = {}; // 起動からの累積電力量 [J]
+    uint16_t pizzas = 0;          // 焼成枚数
+    uint16_t lastWh10 = 0;        // 直近1枚の電力量 [0.1Wh]
+    uint16_t lastDrop10 = 0;      // 直近1枚の投入時の下火温度降下 [0.1℃]
+    uint16_t lastRecoverS = 0;    // 直近1枚の焼き開始からREADY復帰までの時間 [s]
+    uint16_t lastDwellS = 0;      // 直近1枚の投入から取り出しまでの時間 [s]
+
+    // 制御周期ごとに直前1秒間に印加したPWMをゾーン別に積算
+    void tick(const uint8_t pwm[Config::Zones::CNT], float loPlateC) {
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+            zoneJ[i] += (static_cast<uint32_t>(pwm[i]) * static_cast<uint32_t>(Config::Zones::TABLE[i].ratedW) + 127) / 255;
+        if (_tracking && loPlateC < _minLoC) _minLoC = loPlateC;
+    }
+
+    // 役割（上火/下火）ごと・全体の累積電力量 [J]
+    uint32_t roleJ(Config::Zones::Role role) const {
+        uint32_t j = 0;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) if (Config::Zones::TABLE[i].role == role) j += zoneJ[i];
+        return j;
+    }
+    uint32_t totalJ() const { return roleJ(Config::Zones::TOP) + roleJ(Config::Zones::BOTTOM); }
+
+    void bakeStart(uint32_t now, float loPlateC) {
+        if (_tracking) finish(now); // READYに戻る前に次を投入した
+        if (pizzas > 0) {
+            // 投入間隔の指数移動平均（枚/時の算出用）
+            uint32_t interval = (now - _startMs) / 1000UL;
+            if (interval > 0xFFFFUL) interval = 0xFFFFUL;
+            _intervalS = (_intervalS == 0) ? interval : (_intervalS * 7UL + interval * 3UL) / 10UL;
+        }
+        pizzas++;
+        _tracking = true;
+        _startMs = now; _startJ = totalJ();
+        _startLoC = _minLoC = loPlateC;
+    }
+
+    void ready(uint32_t now) { if (_tracking) finish(now); }
+    void unload(uint16_t dwellS) { lastDwellS = dwellS; }
+
+    float totalWh(uint32_t j) const { return j / 3600.0f; }
+
+    // 直近の投入間隔から算出した枚/時（間が空くほど低下）
+    float pizzasPerHour(uint32_t now) const {
+        if (pizzas < 2) return 0.0f;
+        uint32_t since = (now - _startMs) / 1000UL;
+        uint32_t interval = (since > _intervalS) ? since : _intervalS;
+        return (interval == 0) ? 0.0f : 3600.0f / interval;
+    }
+
+private:
+    void finish(uint32_t now) {
+        _tracking = false;
+        lastWh10 = static_cast<uint16_t>((totalJ() - _startJ) / 360UL);
+        float drop = _startLoC - _minLoC;
+        lastDrop10 = static_cast<uint16_t>(drop > 0.0f ? drop * 10.0f : 0.0f);
+        lastRecoverS = static_cast<uint16_t>((now - _startMs) / 1000UL);
+    }
+
+    uint32_t _startMs = 0, _startJ = 0;
+    uint16_t _intervalS = 0;
+    float    _startLoC = 0, _minLoC = 0;
+    bool     _tracking = false;
+};
+
+/* ================= LOAD DETECTOR ================= */
+// 下火の温度差分に対する逐次変化点検出（CUSUM）でピザの投入/取り出しを判定する
+// ドアからの隙間風は上下のプレートを同時に冷やすため、上火の下降分を差し引いて除外する
+class LoadDetector {
+public:
+    static constexpr int8_t NONE = 0, LOADED = 1, UNLOADED = -1;
+
+    // 制御周期ごとに生温度を渡し、検出したイベントを返す
+    int8_t update(float loC, float upC) {
+        if (!_primed) { _lastLo = loC; _lastUp = upC; _primed = true; return NONE; }
+        float dLo = loC - _lastLo, dUp = upC - _lastUp;
+        _lastLo = loC; _lastUp = upC;
+        if (_dwellS < 0xFFFF) _dwellS++;
+
+        float x = -dLo - ((dUp < 0.0f) ? -dUp : 0.0f); // 下火だけの下降量
+        _gLoad = max(0.0f, _gLoad + x - Config::Load::DRIFT_C);
+        if (_gLoad > Config::Load::THRESH_C) {
+            _gLoad = 0; _gUnload = 0; _loaded = true; _dwellS = 0;
+            return LOADED;
+        }
+        if (_loaded) {
+            _gUnload = max(0.0f, _gUnload + dLo - Config::Load::UNLOAD_DRIFT_C);
+            if (_dwellS >= Config::Load::MIN_DWELL_S && _gUnload > Config::Load::UNLOAD_THRESH_C) {
+                _gUnload = 0; _loaded = false;
+                return UNLOADED;
+            }
+        }
+        return NONE;
+    }
+
+    void reset() { _primed = false; _loaded = false; _gLoad = _gUnload = 0; }
+    uint16_t dwellS() const { return _dwellS; } // 投入からの経過秒
+
+private:
+    float    _lastLo = 0, _lastUp = 0, _gLoad = 0, _gUnload = 0;
+    uint16_t _dwellS = 0;
+    bool     _primed = false, _loaded = false;
+};
+
+/* ================= TREND LOG ================= */
+// トレンド表示用の温度記録（ゾーンごとに1バイト×COLS）。書き込み位置がそのまま画面の掃引カーソル
+class TrendLog {
+public:
+    static constexpr uint8_t EMPTY = 0;
+    uint8_t head = 0;  // 次に書き込む列
+    uint8_t seq = 0;   // 記録ごとに増える（描画側の差分検出用）
+
+    // 制御周期ごとに呼び、SAMPLE_S秒ごとに全ゾーンの1列を記録
+    template <class Z> void tick(Z &zs) {
+        if (++_sec < Config::Trend::SAMPLE_S) return;
+        _sec = 0;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) _v[head][i] = quantize(zs[i].plateC);
+        head = (head + 1 < Config::Trend::COLS) ? head + 1 : 0;
+        seq++;
+    }
+
+    uint8_t at(uint8_t col, uint8_t zone) const { return _v[col][zone]; }
+
+    // ago回前の記録（未記録ならEMPTY）
+    uint8_t back(uint8_t ago, uint8_t zone) const {
+        int16_t c = static_cast<int16_t>(head) - 1 - ago;
+        if (c < 0) c += Config::Trend::COLS;
+        return _v[c][zone];
+    }
+
+    static uint8_t quantize(float c) {
+        float q = c / Config::Trend::C_PER_PX + 0.5f;
+        return (isnan(q) || q < 1.0f) ? 1 : (q > 255.0f ? 255 : static_cast<uint8_t>(q));
+    }
+
+private:
+    uint8_t _v[Config::Trend::COLS][Config::Zones::CNT] = {};
+    uint8_t _sec = 0;
+};
+
+/* ================= RECIPE LIBRARY ================= */
+// レシピはPROGMEMの一覧とEEPROMの調整値（オーバーレイ）から項目単位で読み出す
+// RAMにはレシピ番号しか持たないため、レシピ数が増えてもRAM使用量は一定
+namespace RecipeOverlay {
+    constexpr uint8_t EMPTY = 0xFF; // 未使用スロット（消去済みEEPROMの値）
+    enum Field : uint8_t { UP_C, LO_C, BAKE_SEC };
+
+#pragma pack(push, 1)
+    struct Slot { uint8_t idx; uint16_t val[3]; };
+#pragma pack(pop)
+    static_assert(Config::RECIPE_OVERLAY_ADDR + Config::RECIPE_OVERLAY_SLOTS * sizeof(Slot) <= Config::LIFE_ADDR,
+                  "recipe overlay overlaps heater life record");
+
+    inline int slotAddr(uint8_t slot) { return Config::RECIPE_OVERLAY_ADDR + slot * sizeof(Slot); }
+
+    // 指定レシピの調整値が格納されたスロット（無ければ-1）
+    int8_t find(uint8_t idx) {
+        for (uint8_t i = 0; i < Config::RECIPE_OVERLAY_SLOTS; i++)
+            if (EEPROM.read(slotAddr(i)) == idx) return i;
+        return -1;
+    }
+
+    // シリアルコマンドで調整中の値（RAMのみ、1レシピ分）。commit()でEEPROMへ書き込む
+    Slot live = { EMPTY, { 0, 0, 0 } };
+    uint8_t liveMask = 0;
+
+    bool get(uint8_t idx, Field f, uint16_t &v) {
+        if (live.idx == idx && (liveMask & (1 << f))) { v = live.val[f]; return true; }
+        int8_t slot = find(idx);
+        if (slot < 0) return false;
+        EEPROM.get(slotAddr(slot) + 1 + f * sizeof(uint16_t), v);
+        return true;
+    }
+
+    // 調整値を書き込む（空きが無ければ最も古いスロットを再利用）
+    void set(uint8_t idx, Field f, uint16_t v) {
+        int8_t slot = find(idx);
+        if (slot < 0) {
+            slot = find(EMPTY);
+            if (slot < 0) {
+                // 全スロット使用中: 先頭を捨てて詰める
+                for (uint8_t i = 1; i < Config::RECIPE_OVERLAY_SLOTS; i++) {
+                    Slot s; EEPROM.get(slotAddr(i), s); EEPROM.put(slotAddr(i - 1), s);
+                }
+                slot = Config::RECIPE_OVERLAY_SLOTS - 1;
+            }
+            const Config::Recipe &rom = Config::recipes[idx];
+            Slot s = { idx, { pgm_read_word(&rom.upC), pgm_read_word(&rom.loC), pgm_read_word(&rom.bakeSec) } };
+            EEPROM.put(slotAddr(slot), s);
+        }
+        EEPROM.put(slotAddr(slot) + 1 + f * sizeof(uint16_t), v);
+    }
+
+    // 保存せずに値を変更（別のレシピを調整し始めたら未保存分は破棄）
+    void setLive(uint8_t idx, Field f, uint16_t v) {
+        if (live.idx != idx) { live.idx = idx; liveMask = 0; }
+        live.val[f] = v; liveMask |= 1 << f;
+    }
+
+    void commit() {
+        for (uint8_t f = UP_C; f <= BAKE_SEC; f++)
+            if (liveMask & (1 << f)) set(live.idx, static_cast<Field>(f), live.val[f]);
+        liveMask = 0;
+    }
+
+    void clear() {
+        for (uint8_t i = 0; i < Config::RECIPE_OVERLAY_SLOTS; i++) EEPROM.update(slotAddr(i), EMPTY);
+        liveMask = 0;
+    }
+}
+
+// レシピ番号だけを保持し、各項目は必要時に読み出す参照
+struct RecipeRef {
+    uint8_t idx;
+
+    float upC() const { return field(RecipeOverlay::UP_C, &rom().upC); }
+    float loC() const { return field(RecipeOverlay::LO_C, &rom().loC); }
+    uint16_t bakeSec() const { return field(RecipeOverlay::BAKE_SEC, &rom().bakeSec); }
+    uint8_t loPct() const { return pgm_read_byte(&rom().loPct); }
+    const __FlashStringHelper *name() const { return reinterpret_cast<const __FlashStringHelper *>(rom().name); }
+    PGM_P readyMsg() const { return rom().readyMsg; }
+
+private:
+    const Config::Recipe &rom() const { return Config::recipes[idx]; }
+    uint16_t field(RecipeOverlay::Field f, const uint16_t *romVal) const {
+        uint16_t v;
+        return RecipeOverlay::get(idx, f, v) ? v : pgm_read_word(romVal);
+    }
+};
+
+/* ================= ZONES ================= */
+// Config::Zones::TABLE の各行からヒーターを生成する（添字列をテンプレートで展開）
+template <uint8_t... I> struct Indices {};
+template <uint8_t N, uint8_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <uint8_t... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+template <class Idx> struct ZoneArray;
+template <uint8_t... I> struct ZoneArray<Indices<I...>> {
+    IntelligentHeater z[sizeof...(I)];
+    ZoneArray() : z{ IntelligentHeater(Config::Zones::TABLE[I].csPlate, Config::Zones::TABLE[I].csHeater,
+                                       Config::Zones::TABLE[I].ssr, Config::Zones::TABLE[I].modelA,
+                                       Config::Zones::TABLE[I].modelB)... } {}
+    IntelligentHeater &operator[](uint8_t i) { return z[i]; }
 };
 
 /* ================= GLOBALS ================= */
-IntelligentHeater up(Config::Pins::CS_UP_PLATE, Config::Pins::CS_UP_HEATER, Config::Pins::SSR_UP);
-IntelligentHeater lo(Config::Pins::CS_LO_PLATE, Config::Pins::CS_LO_HEATER, Config::Pins::SSR_LO);
+ZoneArray<MakeIndices<Config::Zones::CNT>::type> zones;
+IntelligentHeater &up = zones.z[Config::Zones::UP]; // 上火/下火の代表ゾーン
+IntelligentHeater &lo = zones.z[Config::Zones::LO];
+PowerLink powerLink;
+EnergyMeter meter;
+MainsMeter mains;
+LoadDetector loadDet;
+TrendLog trend;
 // U8x8モード（バッファレス・高速・省メモリ）で初期化
 U8X8_SH1106_128X64_NONAME_HW_I2C oled(/* reset=*/ U8X8_PIN_NONE);
 
-enum class OvenState : uint8_t { IDLE, PREHEAT, READY, BAKING, BAKE_DONE, REST, COOLING, SHUTDOWN, ERROR, TUNING };
+enum class OvenState : uint8_t { IDLE, PREHEAT, READY, BAKING, BAKE_DONE, REST, COOLING, SHUTDOWN, ERROR, TUNING, ECO, PLANNED };
 OvenState oven = OvenState::IDLE, prevOven = OvenState::IDLE;
+constexpr uint8_t OVEN_STATE_CNT = static_cast<uint8_t>(OvenState::PLANNED) + 1;
+
+/* ================= MEMORY PROBE ================= */
+// 起動時にヒープ末端からスタックまでの空き領域を既知のパターンで塗り、
+// 周期的に上書きされずに残った範囲を調べて、空きRAMの最小値とスタックの最深部を求める。
+// 計測後に空き領域を塗り直すことで、ステートごとの最大スタック深さを記録する。
+#if defined(__AVR__)
+extern char __heap_start;
+extern char *__brkval;
+#endif
+
+class MemProbe {
+public:
+    uint16_t minFree = 0xFFFF;                 // 空きRAMの最小値 [byte]
+    uint16_t heapUsed = 0, heapPeak = 0;       // ヒープ使用量（PID_ATune等） [byte]
+    uint16_t stackPeak[OVEN_STATE_CNT] = {};   // ステート別の最大スタック深さ [byte]
+
+    void paint() {
+#if defined(__AVR__)
+        uint8_t *sp = reinterpret_cast<uint8_t *>(SP);
+        for (uint8_t *p = heapEnd(); p < sp - STACK_GUARD; p++) *p = PAINT;
+#endif
+    }
+
+    void scan(uint8_t state) {
+#if defined(__AVR__)
+        uint8_t *end = heapEnd(), *sp = reinterpret_cast<uint8_t *>(SP);
+        uint8_t *p = end;
+        while (p < sp && *p == PAINT) p++; // 塗られたまま残っている範囲 = 一度も使われていない
+        uint16_t freeB = static_cast<uint16_t>(p - end);
+        uint16_t depth = static_cast<uint16_t>(reinterpret_cast<uint8_t *>(RAMEND) - p + 1);
+        heapUsed = static_cast<uint16_t>(end - reinterpret_cast<uint8_t *>(&__heap_start));
+        if (heapUsed > heapPeak) heapPeak = heapUsed;
+        if (freeB < minFree) minFree = freeB;
+        // 前回の計測以降に滞在したステートへ計上
+        if (depth > stackPeak[state]) stackPeak[state] = depth;
+        if (depth > stackPeak[_lastState]) stackPeak[_lastState] = depth;
+        paint();
+#endif
+        _lastState = state;
+    }
+
+    uint16_t deepest() const {
+        uint16_t d = 0;
+        for (uint8_t i = 0; i < OVEN_STATE_CNT; i++) if (stackPeak[i] > d) d = stackPeak[i];
+        return d;
+    }
+
+private:
+    static constexpr uint8_t PAINT = 0xC5, STACK_GUARD = 16;
+#if defined(__AVR__)
+    static uint8_t *heapEnd() {
+        return reinterpret_cast<uint8_t *>(__brkval ? __brkval : &__heap_start);
+    }
+#endif
+    uint8_t _lastState = 0;
+};
+MemProbe memProbe;
 
 #pragma pack(push, 1)
+struct ZoneTuning { float kp, ki, kd, modelA, modelB; };
 struct Settings { 
-    uint32_t magic; uint8_t recipeIdx, limitIdx; float upHealth, loHealth; 
-    float upKp, upKi, upKd;
-    float loKp, loKi, loKd;
+    uint32_t magic; uint8_t recipeIdx, limitIdx; 
+    ZoneTuning zone[Config::Zones::CNT]; // ゾーンごとのPIDゲインと学習済み熱モデル
+    uint16_t boostSec; float readyBandC; uint8_t soakReadyPct; // 運転中に調整可能な制御パラメーター
+    uint16_t heaterCapC; // 素線温度の上限（下げるほど長寿命・低速）
 } settings;
 Settings lastSaveSettings; // EEPROMに保存されている値のシャドウコピー
 #pragma pack(pop)
 
 bool baking = false;
 uint8_t askConfirmation = AskConfirmation::NONE; // 現在表示中の確認プロンプトID
+uint8_t displayPage = DisplayPage::MAIN;   // 表示中のページ（長押しで切替）
 bool confirmationYes = false;              // プロンプトでの選択状態 (Y/N)
-uint8_t tuneStage = 0;                     // オートチューニングの進行状況
+uint8_t tuneStage = 0;                     // オートチューニングの進行状況（ゾーンごとに開始・計測中の2段階）
+// オートチューニングで計測中のゾーン（計測中でなければCNT）
+inline uint8_t tuneZone() { return (tuneStage & 1) ? tuneStage / 2 : Config::Zones::CNT; }
 uint16_t curBakeSec = 0;
-uint32_t bakeStartMs = 0, bakeDoneMsgMs = 0, boostStartMs = 0, restStartMs = 0, lastActMs = 0;
-float lastSavedUpHealth = 100.0f;
-float lastSavedLoHealth = 100.0f;
-Config::Recipe currentRecipe; // 現在のレシピを保持するキャッシュ
-uint8_t targetUpPWM = 0, targetLoPWM = 0; // 計算済みのPWM値
+float bakeDose = 0, bakeRate = 1.0f; // 焼成中の積算熱量 [標準秒] と直近の熱量率
+float ecoUpC = 0, ecoLoC = 0;        // エコ保温中の目標温度
+uint32_t bakeStartMs = 0, bakeDoneMsgMs = 0, boostStartMs = 0, restStartMs = 0, lastActMs = 0; // restStartMsはECO開始にも使用
+// 選択中のレシピ
+inline RecipeRef curRecipe() { return RecipeRef{ settings.recipeIdx }; }
+uint8_t targetPWM[Config::Zones::CNT] = {}; // 計算済みのPWM値
+uint8_t &targetUpPWM = targetPWM[Config::Zones::UP], &targetLoPWM = targetPWM[Config::Zones::LO];
 
 const __FlashStringHelper* temporaryMsg = nullptr;
 uint32_t temporaryMsgEndMs = 0;
 
+// EEPROM未初期化時およびファクトリーリセット時の設定値
+Settings defaultSettings() {
+    Settings s = {
+        Config::EEPROM_MAGIC, 0, 0, {},
+        static_cast<uint16_t>(Config::Hard::BOOST_MS / 1000UL), Config::Hard::READY_BAND_C, Config::Hard::SOAK_READY_PCT,
+        static_cast<uint16_t>(Config::Hard::HEATER_MAX_C)
+    };
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+        s.zone[i] = { 3.5f, 0.05f, 1.0f, Config::Zones::TABLE[i].modelA, Config::Zones::TABLE[i].modelB }; // PID Default
+    return s;
+}
+
+// 設定のPIDゲイン（withModelなら熱モデルも）を全ゾーンに反映
+void applyZoneSettings(bool withModel) {
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        const ZoneTuning &t = settings.zone[i];
+        zones[i].setTunings(t.kp, t.ki, t.kd);
+        if (withModel) zones[i].model = ThermalModel(t.modelA, t.modelB);
+    }
+}
+
+// いずれかのゾーンで異常（センサー/暴走/過昇温/残差診断）が確定しているか
+bool anyZoneError() {
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) if (zones[i].error) return true;
+    return false;
+}
+
+// ERRORへ遷移した原因（resetZonesでゾーンのerrorは消えるため、表示用に保持）
+struct ErrorCause { uint8_t zone, bits, tc; };
+ErrorCause errorCause = {};
+void latchZoneError() {
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+        if (zones[i].error) { errorCause.zone = i; errorCause.bits = zones[i].error; errorCause.tc = zones[i].detachedTc; return; }
+}
+
+void resetZones() { for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].reset(); }
+
+// ヒーター寿命の記録（マジック + ゾーンごとに6バイト、EEPROM.putは変化したバイトのみ書き込む）
+static_assert(Config::LIFE_ADDR + 1 + Config::Zones::CNT * sizeof(HeaterLife::Record) <= 1024, "life records exceed EEPROM");
+
+void saveLife() {
+    EEPROM.update(Config::LIFE_ADDR, Config::Life::MAGIC);
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        EEPROM.put(Config::LIFE_ADDR + 1 + i * sizeof(HeaterLife::Record), zones[i].life.record());
+        zones[i].life.markSaved();
+    }
+}
+
+void loadLife() {
+    if (EEPROM.read(Config::LIFE_ADDR) != Config::Life::MAGIC) return; // 未記録（新品扱い）
+    HeaterLife::Record r;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        EEPROM.get(Config::LIFE_ADDR + 1 + i * sizeof(HeaterLife::Record), r); zones[i].life.restore(r);
+    }
+}
+
+// 全ゾーンのうち最も短い残り寿命 [h]
+float remainingLifeH() {
+    float h = zones[0].life.remainingH(settings.heaterCapC);
+    for (uint8_t i = 1; i < Config::Zones::CNT; i++) h = min(h, zones[i].life.remainingH(settings.heaterCapC));
+    return h;
+}
+
+/* ================= WARM RESTART ================= */
+// ウォッチドッグ/ブラウンアウトによるリセット後も制御を継続するため、
+// 初期化されない.noinit領域に制御状態を保持し、起動時にチェックサムで検証して復元する
+// Caterinaブートローダーは起動時にMCUSRを消して引き継がないため、スケッチからはリセット要因（PORF）を
+// 判別できない。電源投入とそれ以外の区別は、マジックナンバーとチェックサムによる検証だけで行う
+// （電源投入直後のRAMは不定のため弾かれる。ごく短い停電でRAMが保たれた場合はブラウンアウトと同様に復元する）
+#pragma pack(push, 1)
+struct WarmState {
+    uint32_t magic;
+    OvenState oven;
+    bool baking;
+    uint8_t targetPWM[Config::Zones::CNT];
+    uint16_t curBakeSec;
+    float bakeDose;
+    uint32_t bakeAgeMs, boostAgeMs, actAgeMs, restAgeMs, msgAgeMs; // 各タイマーの経過時間
+    IntelligentHeater::Snapshot zone[Config::Zones::CNT];
+    uint16_t crc;
+};
+#pragma pack(pop)
+WarmState warmState __attribute__((section(".noinit")));
+constexpr uint32_t WARM_MAGIC = 0x57524D31;
+
+uint16_t crc16(const uint8_t *p, uint16_t n) {
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= static_cast<uint16_t>(*p++) << 8;
+        for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+}
+
+void saveWarmState(uint32_t now) {
+    WarmState &w = warmState;
+    w.magic = WARM_MAGIC; w.oven = oven; w.baking = baking;
+    memcpy(w.targetPWM, targetPWM, sizeof(targetPWM));
+    w.curBakeSec = curBakeSec; w.bakeDose = bakeDose;
+    w.bakeAgeMs = now - bakeStartMs; w.boostAgeMs = now - boostStartMs;
+    w.actAgeMs = now - lastActMs; w.restAgeMs = now - restStartMs; w.msgAgeMs = now - bakeDoneMsgMs;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].save(w.zone[i]);
+    w.crc = crc16(reinterpret_cast<const uint8_t *>(&w), sizeof(WarmState) - sizeof(w.crc));
+}
+
+// 保持状態が有効なら復元してtrueを返す（電源投入時はRAMが不定のためチェックサムで弾かれる）
+bool restoreWarmState(uint32_t now) {
+    WarmState &w = warmState;
+    bool valid = w.magic == WARM_MAGIC &&
+                 w.crc == crc16(reinterpret_cast<const uint8_t *>(&w), sizeof(WarmState) - sizeof(w.crc));
+    w.magic = 0; // 同じ内容での再復元を防ぐ
+    if (!valid) return false;
+    // 操作待ちや一時的なステートは復元せず通常起動とする（予約予熱は時刻を持たないため通常の予熱になる）
+    switch (w.oven) {
+        case OvenState::PREHEAT: case OvenState::READY: case OvenState::BAKING: case OvenState::BAKE_DONE:
+        case OvenState::REST: case OvenState::COOLING: case OvenState::ERROR: case OvenState::ECO: break;
+        default: return false;
+    }
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+        if (!(w.zone[i].plateC >= 0.0f && w.zone[i].plateC < Config::Hard::PLATE_MAX_C)) return false;
+
+    oven = prevOven = w.oven; baking = w.baking;
+    curBakeSec = w.curBakeSec; bakeDose = w.bakeDose;
+    bakeStartMs = now - w.bakeAgeMs; boostStartMs = now - w.boostAgeMs;
+    lastActMs = now - w.actAgeMs; restStartMs = now - w.restAgeMs; bakeDoneMsgMs = now - w.msgAgeMs;
+    if (oven != OvenState::ERROR) {
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].restore(w.zone[i]);
+        memcpy(targetPWM, w.targetPWM, sizeof(targetPWM));
+    }
+    return true;
+}
+
 // EEPROMへの遅延書き込み処理（頻繁な書き込みによる寿命低下を防止）
 void dirtySave(bool set = false) {
     static bool dirty = false; static uint32_t lastMs = 0;
@@ -285,10 +1662,435 @@ void dirtySave(bool set = false) {
     }
 }
 
+// 役割ごとに最も低いプレート温度（段ごとに投入・冷え方が異なるため、最も遅れた段で判断する）
+float coldestC(Config::Zones::Role role, bool raw = false) {
+    float c = INFINITY;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+        if (Config::Zones::TABLE[i].role == role) c = min(c, raw ? zones[i].rawPlateC : zones[i].plateC);
+    return c;
+}
+
+/* ================= ECO HOLD ================= */
+// 再加熱時の各ゾーンの出力（電力制限内で、calculatePower と同じく優先度の高いゾーンから配分した場合）
+void reheatShare(float u[Config::Zones::CNT]) {
+    Config::Limit lim;
+    memcpy_P(&lim, &Config::limits[settings.limitIdx], sizeof(lim));
+    float w = lim.watts;
+    for (uint8_t n = 0; n < Config::Zones::CNT; n++) {
+        uint8_t i = Config::Zones::byPriority(n);
+        u[i] = constrain(w / Config::Zones::TABLE[i].ratedW, 0.0f, 1.0f);
+        w -= u[i] * Config::Zones::TABLE[i].ratedW;
+    }
+}
+
+// ゾーンごとの出力 u を、役割ごとの定格の合計に対する割合にまとめる
+float roleShare(const float u[Config::Zones::CNT], Config::Zones::Role role) {
+    float w = 0.0f;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++)
+        if (Config::Zones::TABLE[i].role == role) w += u[i] * Config::Zones::TABLE[i].ratedW;
+    return w / Config::Zones::roleW(role);
+}
+
+// 加熱に sec 秒かかった場合の、READYまでの総時間（加熱中に目減りしたSoakの回復を含む）
+// Soakは目標外で 0.5/厚み [%/s] 減少し、目標付近で 1/厚み [%/s] 回復する
+float withSoakS(float sec) {
+    float regain = 0.5f * sec - (100.0f - settings.soakReadyPct) * Config::Hard::STONE_THICK_MM;
+    return sec + ((regain > 0.0f) ? regain : 0.0f);
+}
+
+// withSoakS の逆関数：READYまでの総時間 total のうち加熱に使える秒数（Soakが soak0 [%] から始まる場合）
+float heatBudgetS(float total, float soak0 = 100.0f) {
+    const float th = Config::Hard::STONE_THICK_MM;
+    const float s0 = (soak0 - settings.soakReadyPct) * th;
+    if (total <= 2.0f * s0) return total;          // 加熱中の目減りが閾値までに収まる
+    float h = (total + s0) / 1.5f;
+    if (h <= 2.0f * soak0 * th) return h;          // 目減りした分を目標付近で回復
+    return max(0.0f, total - settings.soakReadyPct * th); // 0まで落ち切り、0から回復
+}
+
+// 現在の温度からREADYに戻るまでの予測秒数
+float ecoReturnS() {
+    RecipeRef r = curRecipe();
+    float u[Config::Zones::CNT];
+    reheatShare(u);
+    float t = 0.0f;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        bool bottom = Config::Zones::TABLE[i].role == Config::Zones::BOTTOM;
+        t = max(t, zones[i].model.secondsTo(zones[i].plateC, (bottom ? r.loC() : r.upC()) - settings.readyBandC, u[i]));
+    }
+    return withSoakS(t);
+}
+
+// ECO_RETURN_S 以内に復帰できる最低の保温温度を学習モデルから算出
+void planEco() {
+    RecipeRef r = curRecipe();
+    float upC = r.upC(), loC = r.loC();
+    float heatS = heatBudgetS(Config::Hard::ECO_RETURN_S * Config::Hard::ECO_MARGIN);
+    float u[Config::Zones::CNT];
+    reheatShare(u);
+    // 保温温度は役割ごとに共通のため、同じ役割で最も冷めやすいゾーンに合わせる
+    ecoUpC = ecoLoC = Config::Hard::ECO_MIN_C;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        if (Config::Zones::TABLE[i].role == Config::Zones::BOTTOM)
+            ecoLoC = max(ecoLoC, zones[i].model.startFor(loC - settings.readyBandC, heatS, u[i]));
+        else
+            ecoUpC = max(ecoUpC, zones[i].model.startFor(upC - settings.readyBandC, heatS, u[i]));
+    }
+    ecoUpC = min(ecoUpC, upC);
+    ecoLoC = min(ecoLoC, loC);
+}
+
+/* ================= READY-BY PLAN ================= */
+// 指定時刻にちょうどREADYとなるよう、ゾーンごとに加熱の開始を遅らせて出力を抑える
+// 一次遅れモデルでは同じ温度まで上げる電力量は加熱時間が短いほど少ない（待つ間は冷めた分しか失わない）が、
+// 素線温度は出力にほぼ比例して上がる。そこで最小電力量（直前に全力）から PLAN_SLACK 増えるまでの範囲で
+// 最も長く低い出力で加熱する。加熱開始後は毎秒、現在温度と残り時間から必要な一定出力を求め直して上限とする
+namespace ReadyPlan {
+    uint32_t deadlineMs = 0;
+    bool started[2] = {};            // Zones::Role（TOP/BOTTOM）ごと
+    float cap[2] = { 1.0f, 1.0f };   // 出力上限（0..1）
+
+    float remainingS(uint32_t now) {
+        int32_t d = static_cast<int32_t>(deadlineMs - now);
+        return (d > 0) ? d / 1000.0f : 0.0f;
+    }
+
+    // 電力量 s·u(s) が全力時（uMax）の 1+PLAN_SLACK 倍に収まる最長の加熱時間（hiS 以下）
+    float longestS(const ThermalModel &m, float from, float to, float uMax, float hiS) {
+        float loS = m.secondsTo(from, to, uMax);
+        if (loS >= hiS) return loS;
+        float limit = loS * uMax * (1.0f + Config::Hard::PLAN_SLACK);
+        if (hiS * m.powerFor(from, to, hiS) <= limit) return hiS;
+        for (uint8_t k = 0; k < 12; k++) { // 電力量は加熱時間に対して単調増加
+            float mid = 0.5f * (loS + hiS);
+            if (mid * m.powerFor(from, to, mid) <= limit) loS = mid; else hiS = mid;
+        }
+        return loS;
+    }
+
+    // 電力制限で上火が同時には届かない場合の、下火優先の全力加熱で合わせる計画（dash）の状態
+    // 加熱中の学習は素線の遅れで大きく振れるため、見積もりには開始時のモデル（plan）を使う。
+    // ゾーンのモデルは上下間の熱の回り込みを含まず、下火の保持出力を多めに見積もる（＝上火に回る電力を
+    // 少なく見積もる）ため、目標に着いたゾーンは実際の保持出力（holdU、0は未計測）で見積もり直す。
+    // stageC は上火を待たせる温度（0は上昇中）、climbMs は上火が上昇を始めた時刻
+    bool dash = false;
+    ThermalModel plan[2] = { up.model, lo.model };
+    float holdU[2] = {};
+    float stageC = 0.0f;
+    uint32_t climbMs = 0;
+
+    // 優先度の高い役割（通常は下火）から電力枠を配分し、目標に届いた役割は保持に必要な分だけ使う全力予熱の所要時間
+    // （役割ごとの代表モデルを10秒刻みで進める。hiS までに終わらなければ hiS）
+    // 配分された出力での漸近値（READY幅以内）に着いた時点を到達とみなす（実機はそこからさらに上がる）
+    float dashS(const ThermalModel *const m[2], const float to[2], const float uMax[2], float hiS) {
+        const float DT = 10.0f;
+        const float rated[2] = { Config::Zones::roleW(Config::Zones::TOP), Config::Zones::roleW(Config::Zones::BOTTOM) };
+        const uint8_t first = Config::Zones::TABLE[Config::Zones::byPriority(0)].role;
+        float c[2] = { coldestC(Config::Zones::TOP), coldestC(Config::Zones::BOTTOM) };
+        float watts = uMax[0] * rated[0] + uMax[1] * rated[1];
+        for (float t = 0.0f; t < hiS; t += DT) {
+            if (c[0] >= to[0] && c[1] >= to[1]) return t;
+            float w = watts;
+            for (uint8_t k = 0; k < 2; k++) {
+                uint8_t i = k ? 1 - first : first;
+                bool held = holdU[i] > 0.0f && c[i] >= to[i] - settings.readyBandC;
+                float need = held ? holdU[i] : (c[i] >= to[i]) ? m[i]->powerFor(c[i], to[i], 0.0f) : 1.0f;
+                float u = min(need, w / rated[i]);
+                w -= u * rated[i];
+                float rate = m[i]->rate(c[i], u);
+                c[i] = min(to[i], c[i] + DT * rate);
+                if (need < 1.0f || rate < m[i]->b * settings.readyBandC) c[i] = to[i]; // 保持中・漸近値に到達
+            }
+        }
+        return hiS;
+    }
+
+    // 上昇中のゾーンが目標に着くまでの秒数。実測の勾配と開始時のモデルの時定数から漸近値を推定する
+    float riseS(const IntelligentHeater &z, const ThermalModel &m, float to) {
+        float inf = z.plateC + z.trend / m.b;
+        return (inf > to) ? logf((inf - z.plateC) / (inf - to)) / m.b : INFINITY;
+    }
+
+    void begin(uint32_t now, uint16_t minutes) {
+        deadlineMs = now + minutes * 60000UL;
+        started[0] = started[1] = false;
+        cap[0] = cap[1] = 0.0f;
+        holdU[0] = holdU[1] = 0.0f;
+        stageC = 0.0f;
+    }
+
+    // 1秒ごとに計画し直す（学習したモデル・レシピ・電力制限の変化を反映）
+    void update(uint32_t now) {
+        RecipeRef r = curRecipe();
+        float u[Config::Zones::CNT], uMax[2], out[Config::Zones::CNT];
+        reheatShare(u);
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) out[i] = targetPWM[i] / 255.0f;
+        uMax[Config::Zones::TOP] = roleShare(u, Config::Zones::TOP);
+        uMax[Config::Zones::BOTTOM] = roleShare(u, Config::Zones::BOTTOM);
+        float budget = heatBudgetS(remainingS(now) * Config::Hard::PLAN_MARGIN, min(up.soak, lo.soak));
+        const IntelligentHeater *z[2] = { &up, &lo };
+        const float to[2] = { r.upC(), r.loC() }; // Soakは目標付近でしか回復しないため、READY幅ではなく目標そのもの
+        const uint8_t T = Config::Zones::TOP, B = Config::Zones::BOTTOM;
+
+        // 電力制限で上火が同時には届かない場合は、予熱と同じ下火優先の全力加熱にかかる時間から開始を決める。
+        // 下火が保持に入った後は、上火の所要時間が残りより短い間は上火を待たせる（待機からの再開はモデル、
+        // 上昇中は実測の勾配で判断する。素線の遅れが抜けるまでの間は勾配を使わない）
+        if (!started[T] && !started[B]) {
+            dash = z[T]->model.steadyC(uMax[T]) <= to[T];
+            plan[T] = z[T]->model; plan[B] = z[B]->model;
+        }
+        if (dash) {
+            const ThermalModel *m[2] = { &plan[0], &plan[1] };
+            for (uint8_t i = 0; i < 2; i++) {
+                if (!started[i]) continue;
+                if (z[i]->plateC < to[i] - settings.readyBandC) continue;
+                float held = roleShare(out, static_cast<Config::Zones::Role>(i));
+                holdU[i] = (holdU[i] > 0.0f) ? holdU[i] + Config::Hard::PLAN_HOLD_K * (held - holdU[i]) : held;
+            }
+            bool due = dashS(m, to, uMax, budget) >= budget;
+            if (!started[T] && due) { started[T] = started[B] = true; climbMs = now; }
+            if (started[T] && holdU[B] > 0.0f) {
+                if (stageC > 0.0f) {
+                    if (due) { stageC = 0.0f; climbMs = now; }
+                } else if (now - climbMs > static_cast<uint32_t>(3000.0f * Config::Hard::TRAJ_LAG_S) &&
+                           z[T]->plateC < to[T] - settings.readyBandC && riseS(*z[T], plan[T], to[T]) < budget) {
+                    stageC = z[T]->plateC;
+                }
+            }
+            cap[T] = cap[B] = started[T] ? 1.0f : 0.0f;
+            return;
+        }
+        for (uint8_t i = 0; i < 2; i++) {
+            if (!started[i]) started[i] = longestS(z[i]->model, z[i]->plateC, to[i], uMax[i], budget) >= budget;
+            cap[i] = started[i] ? constrain(z[i]->model.powerFor(z[i]->plateC, to[i], budget), 0.0f, 1.0f) : 0.0f; // 電力枠はcalculatePowerで配分
+        }
+    }
+}
+
+// 学習した熱モデルを設定に反映（休止時にまとめて保存）
+void storeModels() {
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        settings.zone[i].modelA = zones[i].model.a; settings.zone[i].modelB = zones[i].model.b;
+    }
+    dirtySave(true);
+    saveLife();
+}
+
+// 各ゾーンの目標温度（ステートに応じて切替）
+void zoneTargets(float &upT, float &loT) {
+    bool isHeating = (oven != OvenState::REST && oven != OvenState::COOLING && 
+                      oven != OvenState::SHUTDOWN && oven != OvenState::ERROR
+                      && askConfirmation == AskConfirmation::NONE);
+    if (oven == OvenState::TUNING) { upT = loT = Config::Hard::TUNE_TARGET_C; }
+    else if (!isHeating) { upT = loT = 0; }
+    else if (oven == OvenState::ECO) { upT = ecoUpC; loT = ecoLoC; }
+    else if (oven == OvenState::PLANNED) { // 開始前のゾーンは止めておく
+        RecipeRef r = curRecipe();
+        upT = ReadyPlan::started[Config::Zones::TOP] ? (ReadyPlan::stageC > 0.0f ? ReadyPlan::stageC : r.upC()) : 0.0f;
+        loT = ReadyPlan::started[Config::Zones::BOTTOM] ? r.loC() : 0.0f;
+    }
+    else { RecipeRef r = curRecipe(); upT = r.upC(); loT = r.loC(); }
+}
+
+// 設定温度で焼いた場合を1とした、現在の温度での加熱率
+// 下火はストーンと生地の温度差に比例する伝導、上火は天井からの放射（絶対温度の4乗差）
+float bakeHeatRate(const RecipeRef &r) {
+    const float K = 273.15f, d = Config::Hard::DOUGH_C;
+    float loRate = (lo.plateC - d) / (r.loC() - d);
+    float tu = up.plateC + K, ts = r.upC() + K, td = d + K;
+    float upRate = (tu * tu * tu * tu - td * td * td * td) / (ts * ts * ts * ts - td * td * td * td);
+    uint8_t loPct = r.loPct();
+    float rate = (loPct * loRate + (100 - loPct) * upRate) / 100.0f;
+    return (rate < 0.0f) ? 0.0f : (rate > 2.0f ? 2.0f : rate);
+}
+
+// 焼き上がりまでの残り秒数（現在の加熱率が続くと仮定し、上下限で制限）
+int32_t bakeRemainingS(uint32_t now) {
+    int32_t elapsed = static_cast<int32_t>((now - bakeStartMs) / 1000UL);
+    int32_t minS = static_cast<int32_t>(curBakeSec) * Config::Hard::BAKE_MIN_PCT / 100;
+    int32_t maxS = static_cast<int32_t>(curBakeSec) * Config::Hard::BAKE_MAX_PCT / 100;
+    float rate = (bakeRate < 0.1f) ? 0.1f : bakeRate;
+    int32_t endS = elapsed + static_cast<int32_t>((curBakeSec - bakeDose) / rate + 0.5f);
+    if (endS < minS) endS = minS; else if (endS > maxS) endS = maxS;
+    return (endS > elapsed) ? endS - elapsed : 0;
+}
+
 void startBake(uint16_t sec) {
     baking = true; curBakeSec = sec;
+    bakeDose = 0; bakeRate = 1.0f;
     bakeStartMs = boostStartMs = lastActMs = millis();
     oven = OvenState::BAKING;
+    meter.bakeStart(bakeStartMs, coldestC(Config::Zones::BOTTOM));
+}
+
+/* ================= SERIAL COMMANDS ================= */
+// 稼働中の調整用コマンド（1行1コマンド、改行で実行）
+//   get KEY / set KEY VALUE / list / save / revert / ready MIN
+// setはRAM上の値のみ変更し、saveでEEPROMへ保存する（revertで保存済みの値へ戻す）
+// ready は MIN 分後にREADYとなるよう予約予熱する（0で取り消してすぐに予熱）
+// 未保存の設定値は、エンコーダ操作などによる次回の自動保存にも含まれる
+namespace Cmd {
+    constexpr uint8_t LINE_LEN = 32;
+    enum Type : uint8_t { F32, U16, U8, RCP, LIFE }; // RCPは選択中レシピの項目（offにRecipeOverlay::Field）、LIFEはゾーンの消耗度[%]
+
+    // "*."で始まる項目はゾーンごと（"up.kp" のようにゾーン名で指定）。offはZoneTuning内の位置
+    struct Param { char key[8]; uint8_t type, off; float lo, hi; };
+    const Param params[] PROGMEM = {
+        { "*.kp",   F32, offsetof(ZoneTuning, kp), 0.0f, 50.0f },
+        { "*.ki",   F32, offsetof(ZoneTuning, ki), 0.0f, 5.0f },
+        { "*.kd",   F32, offsetof(ZoneTuning, kd), 0.0f, 50.0f },
+        { "boost",  U16, offsetof(Settings, boostSec), 0.0f, 300.0f },
+        { "band",   F32, offsetof(Settings, readyBandC), 1.0f, 30.0f },
+        { "soak",   U8,  offsetof(Settings, soakReadyPct), 50.0f, 100.0f },
+        { "recipe", U8,  offsetof(Settings, recipeIdx), 0.0f, Config::RECIPE_CNT - 1 },
+        { "limit",  U8,  offsetof(Settings, limitIdx), 0.0f, Config::LIMIT_CNT - 1 },
+        { "r.up",   RCP, RecipeOverlay::UP_C, 0.0f, Config::Hard::PLATE_MAX_C - 1.0f },
+        { "r.lo",   RCP, RecipeOverlay::LO_C, 0.0f, Config::Hard::PLATE_MAX_C - 1.0f },
+        { "r.bake", RCP, RecipeOverlay::BAKE_SEC, 10.0f, Config::Hard::BAKE_SEC_MAX },
+        { "h.cap",  U16, offsetof(Settings, heaterCapC), 600.0f, Config::Hard::HEATER_MAX_C },
+        { "*.wear", LIFE, 0, 0.0f, 100.0f }, // ヒーター交換時は0に戻す
+    };
+    constexpr uint8_t PARAM_CNT = sizeof(params) / sizeof(Param);
+    static_assert(offsetof(Settings, heaterCapC) < 0xFF, "Settings too large for Param::off");
+
+    // ゾーンごとの項目をゾーンzの実体に展開する（keyとoffを書き換え、LIFEのoffはゾーン番号）
+    void bindZone(Param &p, uint8_t z) {
+        char field[sizeof(p.key)];
+        strcpy(field, p.key + 1);
+        strcpy(p.key, Config::Zones::TABLE[z].name); strcat(p.key, field);
+        p.off = (p.type == LIFE) ? z : static_cast<uint8_t>(offsetof(Settings, zone) + z * sizeof(ZoneTuning) + p.off);
+    }
+
+    float read(const Param &p) {
+        uint8_t *base = reinterpret_cast<uint8_t *>(&settings) + p.off;
+        switch (p.type) {
+            case F32: { float v; memcpy(&v, base, sizeof(v)); return v; }
+            case U16: { uint16_t v; memcpy(&v, base, sizeof(v)); return v; }
+            case U8:  return *base;
+            case LIFE: return 100.0f * zones[p.off].life.fraction();
+            default: {
+                RecipeRef r = curRecipe();
+                return (p.off == RecipeOverlay::UP_C) ? r.upC() : (p.off == RecipeOverlay::LO_C) ? r.loC() : r.bakeSec();
+            }
+        }
+    }
+
+    void write(const Param &p, float v) {
+        uint8_t *base = reinterpret_cast<uint8_t *>(&settings) + p.off;
+        uint16_t w = static_cast<uint16_t>(v + 0.5f); // 整数項目は四捨五入
+        switch (p.type) {
+            case F32: memcpy(base, &v, sizeof(v)); break;
+            case U16: memcpy(base, &w, sizeof(w)); break;
+            case U8:  *base = static_cast<uint8_t>(w); break;
+            case LIFE: zones[p.off].life.setPercent(v); break; // 素線の記録はsaveで保存
+            default:  RecipeOverlay::setLive(settings.recipeIdx, static_cast<RecipeOverlay::Field>(p.off), w); break;
+        }
+        applyZoneSettings(false);
+    }
+
+    void print(const Param &p) {
+        Serial.print(p.key); // pはRAMへの写し
+        Serial.print('=');
+        Serial.println(read(p), (p.type == F32 || p.type == LIFE) ? 3 : 0);
+    }
+
+    // KEYに一致する項目をRAMへ読み出す
+    bool find(const char *key, Param &p) {
+        const char *dot = strchr(key, '.');
+        for (uint8_t i = 0; i < PARAM_CNT; i++) {
+            memcpy_P(&p, &params[i], sizeof(p));
+            if (p.key[0] != '*') {
+                if (strcmp(key, p.key) == 0) return true;
+                continue;
+            }
+            if (!dot || strcmp(dot, p.key + 1) != 0) continue;
+            for (uint8_t z = 0; z < Config::Zones::CNT; z++) {
+                const char *name = Config::Zones::TABLE[z].name;
+                if (strlen(name) == static_cast<size_t>(dot - key) && strncmp(key, name, dot - key) == 0) { bindZone(p, z); return true; }
+            }
+        }
+        return false;
+    }
+
+    void run(char *line) {
+        char *cmd = strtok(line, " ");
+        char *key = strtok(nullptr, " ");
+        char *val = strtok(nullptr, " ");
+        Param p;
+        if (!cmd) return;
+        bool isGet = strcmp_P(cmd, PSTR("get")) == 0, isSet = strcmp_P(cmd, PSTR("set")) == 0;
+        if (strcmp_P(cmd, PSTR("list")) == 0) {
+            for (uint8_t i = 0; i < PARAM_CNT; i++) {
+                memcpy_P(&p, &params[i], sizeof(p));
+                if (p.key[0] != '*') { print(p); continue; }
+                for (uint8_t z = 0; z < Config::Zones::CNT; z++) { Param q = p; bindZone(q, z); print(q); }
+            }
+        } else if (strcmp_P(cmd, PSTR("save")) == 0) {
+            RecipeOverlay::commit();
+            dirtySave(true);
+            saveLife();
+            Serial.println(F("OK"));
+        } else if (strcmp_P(cmd, PSTR("revert")) == 0) {
+            settings = lastSaveSettings;
+            RecipeOverlay::liveMask = 0;
+            applyZoneSettings(false);
+            Serial.println(F("OK"));
+        } else if (strcmp_P(cmd, PSTR("ready")) == 0) {
+            char *end;
+            long m = key ? strtol(key, &end, 10) : -1;
+            if (!key || *end != '\0' || m < 0 || m > Config::Hard::PLAN_MAX_MIN) {
+                Serial.println(F("ERR value"));
+            } else if (oven != OvenState::IDLE && oven != OvenState::PREHEAT && oven != OvenState::READY &&
+                       oven != OvenState::ECO && oven != OvenState::PLANNED) {
+                Serial.println(F("ERR state")); // 焼成中・停止系・異常時は受け付けない
+            } else {
+                if (m == 0) { if (oven == OvenState::PLANNED) oven = OvenState::PREHEAT; }
+                else {
+                    if (oven == OvenState::IDLE) resetZones(); // 起動直後（IDLE→PREHEATと同じ初期化）
+                    ReadyPlan::begin(millis(), static_cast<uint16_t>(m)); oven = OvenState::PLANNED;
+                }
+                Serial.println(F("OK"));
+            }
+        } else if (!isGet && !isSet) {
+            Serial.println(F("ERR cmd"));
+        } else if (!key || !find(key, p)) {
+            Serial.println(F("ERR key"));
+        } else if (isGet) {
+            print(p);
+        } else {
+            char *end;
+            float v = val ? static_cast<float>(strtod(val, &end)) : 0.0f;
+            if (!val || *end != '\0') {
+                Serial.println(F("ERR value"));
+            } else if (!(v >= p.lo && v <= p.hi)) { // "nan"もstrtodを通るため、否定形でNaNを弾く
+                Serial.print(F("ERR range ")); Serial.print(p.lo, 3); Serial.print(F("..")); Serial.println(p.hi, 3);
+            } else if (oven == OvenState::TUNING) {
+                Serial.println(F("ERR tuning")); // 計測結果で上書きされるため
+            } else {
+                write(p, v);
+                print(p);
+            }
+        }
+    }
+
+    // 受信済みの文字だけを処理し、ブロックしない
+    void poll(uint32_t now) {
+        static char buf[LINE_LEN];
+        static uint8_t len = 0;
+        static bool overflow = false;
+        while (Serial.available() > 0) {
+            char c = static_cast<char>(Serial.read());
+            if (c == '\r' || c == '\n') {
+                if (overflow) Serial.println(F("ERR long"));
+                else if (len) { buf[len] = '\0'; lastActMs = now; run(buf); }
+                len = 0; overflow = false;
+            } else if (len < LINE_LEN - 1) {
+                buf[len++] = c;
+            } else {
+                overflow = true;
+            }
+        }
+    }
 }
 
 // エンコーダとスイッチのデバウンス処理付き入力管理
@@ -305,7 +2107,6 @@ void handleInput(uint32_t now) {
             confirmationYes = !confirmationYes; // Y/N 切り替え
         } else if (oven != OvenState::ERROR && oven != OvenState::TUNING) {
             settings.recipeIdx = (settings.recipeIdx + dir + Config::RECIPE_CNT) % Config::RECIPE_CNT;
-            memcpy_P(&currentRecipe, &Config::recipes[settings.recipeIdx], sizeof(currentRecipe));
             dirtySave(true);
         }
     }
@@ -330,34 +2131,29 @@ void handleInput(uint32_t now) {
                 if (confirmationYes) {
                     // [汎用] 選択されたアクションの実行
                     if (askConfirmation == AskConfirmation::CANCEL_TUNE) {
-                        up.stopTune(); lo.stopTune();
-                        up.reset(); lo.reset();
+                        for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].stopTune();
+                        resetZones();
                         oven = OvenState::SHUTDOWN;
                         tuneStage = 0; // 進行状況をリセット
                         temporaryMsg = F("Canceled");
                         temporaryMsgEndMs = now + 2000UL;
                         dirtySave(true);
                     } else if (askConfirmation == AskConfirmation::START_TUNE) {
-                        up.reset(); lo.reset();
+                        resetZones();
                         oven = OvenState::TUNING;
                         tuneStage = 0;
                         temporaryMsg = F("Tuning Start");
                         temporaryMsgEndMs = now + 2000UL;
                     } else if (askConfirmation == AskConfirmation::FACTORY_RESET) {
                         // デフォルト値の設定と保存
-                        settings = {
-                            Config::EEPROM_MAGIC, 0, 0, 100.0f, 100.0f, 
-                            3.5f, 0.05f, 1.0f, 
-                            3.5f, 0.05f, 1.0f
-                        };
+                        settings = defaultSettings();
                         EEPROM.put(0, settings);
                         lastSaveSettings = settings;
                         // 設定を即時反映
-                        up.setTunings(settings.upKp, settings.upKi, settings.upKd);
-                        lo.setTunings(settings.loKp, settings.loKi, settings.loKd);
-                        memcpy_P(&currentRecipe, &Config::recipes[settings.recipeIdx], sizeof(currentRecipe));
+                        applyZoneSettings(true);
+                        RecipeOverlay::clear();
                         
-                        up.reset(); lo.reset();
+                        resetZones();
                         oven = OvenState::SHUTDOWN;
                         
                         temporaryMsg = F("Factory Reset");
@@ -365,6 +2161,8 @@ void handleInput(uint32_t now) {
                     }
                 }
                 askConfirmation = AskConfirmation::NONE; // プロンプトを閉じる
+            } else if (oven == OvenState::ECO || oven == OvenState::PLANNED) {
+                oven = OvenState::PREHEAT; // エコ保温・予約予熱から、すぐに再加熱
             } else if (oven != OvenState::ERROR && oven != OvenState::TUNING) {
                 settings.limitIdx = (settings.limitIdx + 1) % Config::LIMIT_CNT;
                 dirtySave(true);
@@ -386,6 +2184,8 @@ void handleInput(uint32_t now) {
             } else if (oven == OvenState::IDLE) {
                 askConfirmation = AskConfirmation::FACTORY_RESET;
                 confirmationYes = false;
+            } else if (askConfirmation == AskConfirmation::NONE) {
+                displayPage = (displayPage + 1) % DisplayPage::COUNT; // 表示ページ切替
             }
             longPressHandled = true;
         }
@@ -395,9 +2195,10 @@ void handleInput(uint32_t now) {
 
 // 全体電力を制限枠内に収めるための動的PWM制限アルゴリズム
 void calculatePower(uint32_t now) {
+    CYCLE_PROBE(POWER);
     if (oven == OvenState::TUNING) {
-        targetUpPWM = static_cast<uint8_t>(up.pidOut());
-        targetLoPWM = static_cast<uint8_t>(lo.pidOut());
+        memset(targetPWM, 0, sizeof(targetPWM));
+        if (tuneZone() < Config::Zones::CNT) targetPWM[tuneZone()] = static_cast<uint8_t>(zones[tuneZone()].pidOut());
         return;
     }
     
@@ -405,85 +2206,300 @@ void calculatePower(uint32_t now) {
     Config::Limit lim;
     memcpy_P(&lim, &Config::limits[settings.limitIdx], sizeof(lim));
     int32_t limW = static_cast<int32_t>(lim.watts);
-    int32_t ratedUp = static_cast<int32_t>(Config::Hard::RATED_UP_W);
-    int32_t ratedLo = static_cast<int32_t>(Config::Hard::RATED_LO_W);
 
-    // Boostモード: 生地の投入による下火の低下を防ぐため、下火に優先的に電力を割り当てる
-    if (baking && now - boostStartMs < Config::Hard::BOOST_MS) {
-        int32_t upReqW = (static_cast<int32_t>(up.pidOut()) * ratedUp) / 255;
-        int32_t loReqW = (static_cast<int32_t>(lo.pidOut()) * ratedLo) / 255;
+    // Boostモード: 生地の投入によるストーンの低下を防ぐため、BOTTOMゾーンに順位によらず優先的に割り当てる
+    bool boost = baking && now - boostStartMs < settings.boostSec * 1000UL;
+    // 電流センサー搭載時はゾーンごとの実測値（フル出力時の電流×公称電圧）で換算する
+    int32_t reqW[Config::Zones::CNT], fullW[Config::Zones::CNT];
+    int32_t demandW = 0;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        int32_t rated = fullW[i] = static_cast<int32_t>(mains.fullW(i));
+        int32_t pid = static_cast<int32_t>(zones[i].pidOut());
+        demandW += pid * rated;
+        reqW[i] = (pid * rated) / 255;
+    }
+    demandW /= 255;
+
+    // 協調運転時は自機の要求電力（ヒーター以外の基底分を含む）を公開し、マスターから配分された枠で上限を絞る
+    int32_t baseW = static_cast<int32_t>(mains.baseW());
+    if (anyZoneError()) demandW = 0;
+    demandW += baseW;
+    int32_t budgetW = powerLink.update(now, (demandW < limW) ? demandW : limW);
+    if (Config::Link::ROLE != Config::Link::ROLE_STANDALONE && budgetW < limW) limW = budgetW;
+
+    // 優先度の高いゾーン（通常は下火）から順に要求を満たし、残りの電力枠を次のゾーンに提供
+    // （枠が基底分に満たない場合は0。負の枠がPWMに化けないようにする）
+    int32_t remW = (limW > baseW) ? (limW - baseW) : 0;
+    for (uint8_t n = 0; n < 2 * Config::Zones::CNT; n++) {
+        uint8_t i = Config::Zones::byPriority(n % Config::Zones::CNT);
+        if ((boost && Config::Zones::TABLE[i].role == Config::Zones::BOTTOM) != (n < Config::Zones::CNT)) continue; // 1巡目はBoost中のBOTTOMのみ
+        int32_t w = (reqW[i] < remW) ? reqW[i] : remW;
+        remW = (remW - w > 0) ? (remW - w) : 0;
+        int32_t pwm = (w * 255) / fullW[i];
+        targetPWM[i] = static_cast<uint8_t>(pwm < 255 ? pwm : 255);
+        zones[i].allotted(targetPWM[i]);
+    }
+    
+    // 重大なエラーが発生している場合は出力を強制遮断
+    if (anyZoneError() || oven == OvenState::ERROR) memset(targetPWM, 0, sizeof(targetPWM));
+}
 
-        int32_t loActiveW = (limW < loReqW) ? limW : loReqW; 
-        int32_t upMaxW = (limW - loActiveW > 0) ? (limW - loActiveW) : 0;
+void renderStatusLine();
 
-        int32_t upAllocW = (upReqW < upMaxW) ? upReqW : upMaxW;
-        targetUpPWM = static_cast<uint8_t>((upAllocW * 255) / ratedUp);
-        targetLoPWM = static_cast<uint8_t>((loActiveW * 255) / ratedLo);
-    } else {
-        // 通常時: 下火を最優先し、残りの電力枠を上火に提供
-        int32_t loReqW = (static_cast<int32_t>(lo.pidOut()) * ratedLo) / 255;
-        int32_t loW = (loReqW < limW) ? loReqW : limW;
-        
-        int32_t remW = (limW - loW > 0) ? (limW - loW) : 0;
-        int32_t upReqW = (static_cast<int32_t>(up.pidOut()) * ratedUp) / 255;
-        int32_t upW = (upReqW < remW) ? upReqW : remW;
+// 統計ページの1行（ラベル+値+単位、行末まで空白で上書き）
+void statLine(uint8_t row, const __FlashStringHelper *label, float v, uint8_t digits, const __FlashStringHelper *unit) {
+    oled.setCursor(0, row);
+    size_t n = oled.print(label);
+    n += oled.print(v, digits);
+    n += oled.print(unit);
+    while (n++ < 16) oled.print(' ');
+}
 
-        targetUpPWM = static_cast<uint8_t>((upW * 255) / ratedUp);
-        targetLoPWM = static_cast<uint8_t>((loW * 255) / ratedLo);
+// 統計ページ：電力量と処理能力
+void renderStats() {
+    oled.setFont(u8x8_font_chroma48medium8_r);
+    uint32_t now = millis();
+    statLine(0, F("Up    "), meter.totalWh(meter.roleJ(Config::Zones::TOP)), 1, F("Wh"));
+    statLine(1, F("Low   "), meter.totalWh(meter.roleJ(Config::Zones::BOTTOM)), 1, F("Wh"));
+    statLine(2, F("Pizza "), meter.lastWh10 / 10.0f, 1, F("Wh"));
+    statLine(3, F("Drop  "), meter.lastDrop10 / 10.0f, 1, F("C"));
+    statLine(4, F("Recov "), meter.lastRecoverS, 0, F("s"));
+    statLine(5, F("Rate  "), meter.pizzasPerHour(now), 1, F("/h"));
+    statLine(6, F("Count "), meter.pizzas, 0, F(""));
+    renderStatusLine();
+}
+
+// 診断ページ：空きRAMとステート別の最大スタック深さ
+void renderDiag() {
+    static const char TAGS[] PROGMEM = "IDPHRDBKBDRSCLSDERTUECPL"; // OvenStateの略称（2文字ずつ）
+    oled.setFont(u8x8_font_chroma48medium8_r);
+    oled.setCursor(0, 0);
+    size_t n = oled.print(F("F")); n += oled.print(memProbe.minFree);
+    n += oled.print(F(" H")); n += oled.print(memProbe.heapUsed);
+    n += oled.print(F("/")); n += oled.print(memProbe.heapPeak);
+    while (n++ < 16) oled.print(' ');
+    for (uint8_t i = 0; i < OVEN_STATE_CNT; i++) {
+        uint8_t col = (i & 1) ? 8 : 0;
+        oled.setCursor(col, 1 + i / 2);
+        n = oled.print(static_cast<char>(pgm_read_byte(&TAGS[i * 2])));
+        n += oled.print(static_cast<char>(pgm_read_byte(&TAGS[i * 2 + 1])));
+        n += oled.print(' ');
+        n += oled.print(memProbe.stackPeak[i]);
+        while (n++ < 8) oled.print(' ');
     }
-    
-    // 重大なエラーが発生している場合は出力を強制遮断
-    if (up.error || lo.error || oven == OvenState::ERROR) { targetUpPWM = targetLoPWM = 0; }
+    renderStatusLine();
+}
+
+// トレンドページ：ゾーンごとの帯（6行をゾーン数で等分）に掃引グラフ、右端に温度・傾き[℃/min]・Soak
+namespace TrendView {
+    constexpr uint8_t SHOWN = (Config::Zones::CNT < Config::Trend::ROWS) ? Config::Zones::CNT : Config::Trend::ROWS;
+    constexpr uint8_t BAND_ROWS = Config::Trend::ROWS / SHOWN;
+    constexpr uint8_t TILE_COLS = Config::Trend::COLS / 8;
+    bool stale = true;   // 次回は全体を描き直す（ページ切替時）
+    uint8_t drawnSeq = 0;
+    int16_t drawnTop[SHOWN];
+
+    // 帯の上端（記録値の単位）
+    int16_t topQ(uint8_t zone) {
+        RecipeRef r = curRecipe();
+        float ref = (Config::Zones::TABLE[zone].role == Config::Zones::BOTTOM) ? r.loC() : r.upC();
+        return static_cast<int16_t>((ref + Config::Trend::ABOVE_C) / Config::Trend::C_PER_PX + 0.5f);
+    }
+
+    // 掃引カーソル直前の消去列か
+    bool inGap(uint8_t col) {
+        uint8_t d = (col + Config::Trend::COLS - trend.head) % Config::Trend::COLS;
+        return d < Config::Trend::GAP;
+    }
+
+    // 1タイル（8x8、各バイトが縦8pxで下位ビットが上）を合成して送る
+    void drawTile(uint8_t zone, uint8_t row, uint8_t tc, int16_t top) {
+        constexpr int16_t H = BAND_ROWS * 8;
+        constexpr int16_t REF_Y = Config::Trend::ABOVE_C / Config::Trend::C_PER_PX;
+        uint8_t tile[8];
+        int16_t y0 = row * 8;
+        for (uint8_t k = 0; k < 8; k++) {
+            uint8_t col = tc * 8 + k;
+            uint8_t b = 0;
+            if (!inGap(col)) {
+                if ((col & 3) == 0 && REF_Y >= y0 && REF_Y < y0 + 8) b |= 1 << (REF_Y - y0); // レシピ温度の点線
+                uint8_t v = trend.at(col, zone);
+                if (v != TrendLog::EMPTY) {
+                    uint8_t pc = col ? col - 1 : Config::Trend::COLS - 1;
+                    uint8_t pv = inGap(pc) ? TrendLog::EMPTY : trend.at(pc, zone);
+                    int16_t y = constrain(top - v, 0, H - 1);
+                    int16_t py = (pv == TrendLog::EMPTY) ? y : constrain(top - pv, 0, H - 1);
+                    int16_t lo = min(y, py), hi = max(y, py); // 前の列と縦線でつなぐ
+                    for (int16_t yy = max(lo, y0); yy <= hi && yy < y0 + 8; yy++) b |= 1 << (yy - y0);
+                }
+            }
+            tile[k] = b;
+        }
+        oled.drawTile(tc, 1 + zone * BAND_ROWS + row, 1, tile);
+    }
+}
+
+void renderTrend() {
+    using namespace TrendView;
+    oled.setFont(u8x8_font_chroma48medium8_r);
+    bool full = stale || static_cast<uint8_t>(trend.seq - drawnSeq) > 1;
+    int16_t top[SHOWN];
+    for (uint8_t z = 0; z < SHOWN; z++) {
+        top[z] = topQ(z);
+        if (top[z] != drawnTop[z]) full = true; // レシピ変更で縦軸が変わった
+    }
+
+    if (full) {
+        oled.setCursor(0, 0);
+        size_t n = oled.print(F("Trend "));
+        n += oled.print(Config::Trend::COLS * Config::Trend::SAMPLE_S / 60);
+        n += oled.print(F("min"));
+        while (n++ < 12) oled.print(' ');
+        oled.print(F("C/m "));
+    }
+
+    // 変化したタイル列だけ送る（新しい列、消去幅に入った列、消去幅の直後で前とのつなぎが消えた列）
+    uint16_t cols = 0;
+    if (full) cols = (1U << TILE_COLS) - 1;
+    else if (trend.seq != drawnSeq) {
+        uint8_t h = trend.head, n = Config::Trend::COLS;
+        cols = (1U << ((h + n - 1) % n / 8)) | (1U << ((h + Config::Trend::GAP - 1) % n / 8)) |
+               (1U << ((h + Config::Trend::GAP) % n / 8));
+    }
+    for (uint8_t z = 0; z < SHOWN; z++)
+        for (uint8_t r = 0; r < BAND_ROWS; r++)
+            for (uint8_t tc = 0; tc < TILE_COLS; tc++)
+                if (cols & (1U << tc)) drawTile(z, r, tc, top[z]);
+    for (uint8_t z = 0; z < SHOWN; z++) drawnTop[z] = top[z];
+    drawnSeq = trend.seq;
+    stale = false;
+
+    // 右端の数値（1秒ごと）
+    constexpr uint8_t PER_MIN = Config::Trend::SLOPE_S / Config::Trend::SAMPLE_S;
+    for (uint8_t z = 0; z < SHOWN; z++) {
+        uint8_t y = 1 + z * BAND_ROWS;
+        oled.setCursor(TILE_COLS, y);
+        size_t n = oled.print(Config::Zones::TABLE[z].tag);
+        n += oled.print((int)zones[z].plateC);
+        while (n++ < 4) oled.print(' ');
+        if (BAND_ROWS < 2) continue;
+        oled.setCursor(TILE_COLS, y + 1);
+        uint8_t old = trend.back(PER_MIN - 1, z);
+        if (old == TrendLog::EMPTY) {
+            n = oled.print(F("--"));
+        } else {
+            float d = (zones[z].plateC - old * Config::Trend::C_PER_PX) * 60.0f / Config::Trend::SLOPE_S;
+            int16_t sl = static_cast<int16_t>(d + (d < 0.0f ? -0.5f : 0.5f));
+            n = (sl > 0) ? oled.print('+') : 0;
+            n += oled.print(sl);
+        }
+        while (n++ < 4) oled.print(' ');
+        if (BAND_ROWS < 3) continue;
+        oled.setCursor(TILE_COLS, y + 2);
+        n = oled.print((int)zones[z].soak);
+        n += oled.print('%');
+        while (n++ < 4) oled.print(' ');
+    }
+    renderStatusLine();
 }
 
 void renderOLED() {
+    CYCLE_PROBE(OLED);
+    if (displayPage == DisplayPage::STATS) { renderStats(); return; }
+    if (displayPage == DisplayPage::DIAG) { renderDiag(); return; }
+    if (displayPage == DisplayPage::TREND) { renderTrend(); return; }
+
     // oled.clear(); // 削除：点滅防止のため
 
     oled.setFont(u8x8_font_chroma48medium8_r); 
 
     // 1行目：レシピ名と電力制限 (上書き用に空白を付加)
-    oled.setCursor(0, 0); oled.print(currentRecipe.name);
+    oled.setCursor(0, 0); oled.print(curRecipe().name());
     oled.print(F("        ")); // 古い名前を消すための空白
     oled.setCursor(11, 0);
-    char limitLabel[6];
-    strcpy_P(limitLabel, Config::limits[settings.limitIdx].label);
-    oled.print(limitLabel);
-    
-    // 2-3行目：温度 (2x2倍角)
-    // Uは0列、Lは8列から開始。2x2なので行2と行3を占有します。
-    oled.setFont(u8x8_font_px437wyse700b_2x2_r);
-    oled.setCursor(0, 2); oled.print(F("U")); oled.print((int)up.plateC);
-    oled.print(F(" ")); // 桁数が減った時のゴミ消し
+    if (Config::Link::ROLE != Config::Link::ROLE_STANDALONE) {
+        // 協調運転中は配分された電力枠を表示（末尾!はフェイルセーフ中）
+        uint16_t w = powerLink.appliedW();
+        oled.print(w / 1000); oled.print('.'); oled.print((w % 1000) / 100);
+        oled.print(powerLink.failsafe() ? F("k!") : F("k "));
+    } else {
+        char limitLabel[6];
+        strcpy_P(limitLabel, Config::limits[settings.limitIdx].label);
+        oled.print(limitLabel);
+    }
     
-    oled.setCursor(8, 2); oled.print(F("L")); oled.print((int)lo.plateC);
-    oled.print(F(" "));
+    // 2-3行目：温度
+    // 2ゾーンまでは2x2倍角で8列ずつ（行2と行3を占有）、それ以上は通常文字で1行4ゾーンまで並べる
+    constexpr bool BIG = Config::Zones::CNT <= 2;
+    constexpr uint8_t COLS = BIG ? 8 : 4, PER_ROW = 16 / COLS;
+    if (BIG) oled.setFont(u8x8_font_px437wyse700b_2x2_r);
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+        oled.setCursor((i % PER_ROW) * COLS, 2 + (BIG ? 0 : i / PER_ROW));
+        oled.print(Config::Zones::TABLE[i].tag); oled.print((int)zones[i].plateC);
+        oled.print(F(" ")); // 桁数が減った時のゴミ消し
+    }
     
     oled.setFont(u8x8_font_chroma48medium8_r); 
 
     // 4行目：Soak と 警告
     // 警告は温度のすぐ下（行4）に配置
     oled.setCursor(0, 4);
-    if (settings.upHealth < 20.0f || settings.loHealth < 20.0f) {
+    if (remainingLifeH() < Config::Life::MAINT_H) {
         oled.print(F("!! MAINT !! ")); 
     } else {
         oled.print(F("            ")); // 警告が消えた時にクリア
     }
     
     oled.setCursor(12, 4); 
-    int sk = (int)min(up.soak, lo.soak);
+    float minSoak = zones[0].soak;
+    for (uint8_t i = 1; i < Config::Zones::CNT; i++) minSoak = min(minSoak, zones[i].soak);
+    int sk = (int)minSoak;
     if(sk < 100) oled.print(F(" ")); // 桁揃え
     oled.print(sk); oled.print(F("%"));
 
     // 5-6行目：焼き時間
     oled.setCursor(0, 5);
     if (oven == OvenState::BAKING) {
-        int32_t rem = static_cast<int32_t>(curBakeSec) - static_cast<int32_t>((millis() - bakeStartMs) / 1000);
-        oled.print(F("Bake: ")); oled.print(max(0L, rem)); oled.print(F("s  "));
+        oled.print(F("Bake: ")); oled.print(bakeRemainingS(millis())); oled.print(F("s  "));
+    } else if (oven == OvenState::ECO) {
+        oled.print(F("Back: ")); oled.print(static_cast<int32_t>(ecoReturnS() + 0.5f)); oled.print(F("s  "));
+    } else if (oven == OvenState::PLANNED) {
+        oled.print(F("Ready in ")); oled.print(static_cast<int32_t>(ReadyPlan::remainingS(millis()) / 60.0f + 0.5f)); oled.print(F("min  "));
     } else {
         oled.print(F("                ")); // 非表示時にクリア
     }
     
-    // 7行目：ステータス (最下段)
+    renderStatusLine();
+}
+
+// 熱電対アンプの異常内容（例: "TC UP-H open"）。複数ある場合は最初の1つ
+void tcFaultMsg(char *buf) {
+    static const char KINDS[] PROGMEM = "open\0 short\0range\0bus\0  "; // Faultのビット順（6文字ずつ）
+    uint8_t f = up.tcFault ? up.tcFault : lo.tcFault;
+    strcpy_P(buf, up.tcFault ? PSTR("TC UP-") : PSTR("TC LO-"));
+    strcat_P(buf, (f & 0x0F) ? PSTR("P ") : PSTR("H "));
+    if (!(f & 0x0F)) f >>= 4;
+    uint8_t bit = 0;
+    while (!(f & (1 << bit))) bit++;
+    strcat_P(buf, KINDS + bit * 6);
+}
+
+// 残差診断による異常の表示（例: "SSR-UP stuck" "HTR-LO open" "TC UP-P detach"）
+void residualMsg(char *buf) {
+    const char *name = Config::Zones::TABLE[errorCause.zone].name;
+    char zn[3] = { static_cast<char>(name[0] & ~0x20), static_cast<char>(name[1] & ~0x20), '\0' }; // 英小文字→大文字
+    if (errorCause.bits & 8) {
+        strcpy_P(buf, PSTR("SSR-")); strcat(buf, zn); strcat_P(buf, PSTR(" stuck"));
+    } else if (errorCause.bits & 16) {
+        strcpy_P(buf, PSTR("HTR-")); strcat(buf, zn); strcat_P(buf, PSTR(" open"));
+    } else {
+        strcpy_P(buf, PSTR("TC ")); strcat(buf, zn);
+        strcat_P(buf, (errorCause.tc & 1) ? PSTR("-P detach") : PSTR("-H detach"));
+    }
+}
+
+// 7行目：ステータス (最下段、全ページ共通)
+void renderStatusLine() {
     oled.setCursor(0, 7);
     char buf[17];
     const char* src = nullptr;
@@ -501,12 +2517,18 @@ void renderOLED() {
         temporaryMsg = nullptr;
         switch (oven) {
             case OvenState::PREHEAT:   src = Config::Msg::PREHEAT; isProgmem = true; break;
-            case OvenState::READY:     src = currentRecipe.readyMsg; isProgmem = false; break;
+            case OvenState::READY:     src = curRecipe().readyMsg(); isProgmem = true; break;
             case OvenState::BAKING:    src = "Baking..."; isProgmem = false; break;
             case OvenState::BAKE_DONE: src = Config::Msg::BAKE_DONE; isProgmem = true; break;
             case OvenState::REST:      src = Config::Msg::REST; isProgmem = true; break;
             case OvenState::COOLING:   src = Config::Msg::COOL; isProgmem = true; break;
-            case OvenState::ERROR:     src = Config::Msg::ERROR; isProgmem = true; break;
+            case OvenState::ECO:       src = Config::Msg::ECO; isProgmem = true; break;
+            case OvenState::PLANNED:   src = Config::Msg::PLANNED; isProgmem = true; break;
+            case OvenState::ERROR:
+                if (up.tcFault || lo.tcFault) { tcFaultMsg(buf); src = buf; isProgmem = false; }
+                else if (errorCause.bits & (8 | 16 | 32)) { residualMsg(buf); src = buf; isProgmem = false; }
+                else { src = Config::Msg::ERROR; isProgmem = true; }
+                break;
             case OvenState::TUNING:    src = "Auto Tuning..."; isProgmem = false; break;
             default: break;
         }
@@ -530,6 +2552,9 @@ void renderOLED() {
 
 void updateDisplay(uint32_t now) {
     static uint32_t lastOledMs = 0;
+    static uint8_t lastPage = DisplayPage::MAIN;
+    // ページ切替時のみ全消去（レイアウトが異なるため）
+    if (displayPage != lastPage) { oled.clear(); lastPage = displayPage; lastOledMs = now - 1000UL; TrendView::stale = true; }
     // Flash節約のため、部分更新ロジックを廃止し、単純な定期更新に戻す
     // 1秒経過、またはオーブンの状態（IDLE/BAKING等）が変わった時のみ再描画
     if (oven != prevOven || now - lastOledMs >= 1000UL) {
@@ -544,35 +2569,37 @@ void runControlTick(uint32_t now) {
     static uint32_t lastCtrlMs = 0;
     if (now - lastCtrlMs >= 1000UL) {
         lastCtrlMs = now;
-        const Config::Recipe &r = currentRecipe;
+        memProbe.scan(static_cast<uint8_t>(oven));
+        RecipeRef r = curRecipe();
+        saveWarmState(now); // 前周期終了時点の状態を保持
+        meter.tick(targetPWM, coldestC(Config::Zones::BOTTOM)); // 直前1秒間の印加分を積算
+        trend.tick(zones);
 
         // [TUNINGステート] PIDパラメーターの自動計測
         if (oven == OvenState::TUNING) {
-            if (tuneStage == 0) {
-                up.startTune(); tuneStage = 1;
-            } else if (tuneStage == 1 && !up.isTuning()) {
-                settings.upKp = up.getKp(); settings.upKi = up.getKi(); settings.upKd = up.getKd();
-                dirtySave(true); tuneStage = 2;
-            } else if (tuneStage == 2) {
-                lo.startTune(); tuneStage = 3;
-            } else if (tuneStage == 3 && !lo.isTuning()) {
-                settings.loKp = lo.getKp(); settings.loKi = lo.getKi(); settings.loKd = lo.getKd();
-                dirtySave(true); oven = OvenState::SHUTDOWN; tuneStage = 0;
-            }
-            if (tuneStage == 1) {
-                up.tick(Config::Hard::TUNE_TARGET_C, settings.upHealth);
-                lo.tick(0, settings.loHealth);
+            // 表の順に1ゾーンずつ計測（偶数: 計測開始、奇数: 計測中）
+            uint8_t z = tuneStage / 2;
+            if (!(tuneStage & 1)) {
+                zones[z].startTune(); tuneStage++;
+            } else if (!zones[z].isTuning()) {
+                ZoneTuning &t = settings.zone[z];
+                t.kp = zones[z].getKp(); t.ki = zones[z].getKi(); t.kd = zones[z].getKd();
+                dirtySave(true); tuneStage++;
+                if (tuneStage == 2 * Config::Zones::CNT) {
+                    resetZones(); oven = OvenState::SHUTDOWN; tuneStage = 0; // 計測中の積分項を停止後に持ち越さない
+                }
             }
-            if (tuneStage == 3) {
-                lo.tick(Config::Hard::TUNE_TARGET_C, settings.loHealth);
-                up.tick(0, settings.upHealth);
+            // 計測中のゾーン以外は目標0で監視のみ
+            for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+                if (tuneStage & 1) zones[i].tick(i == tuneZone() ? Config::Hard::TUNE_TARGET_C : 0.0f, settings.heaterCapC);
             }
 
             // チューニング中も安全装置は常に監視する
-            if (up.error || lo.error) {
+            if (anyZoneError()) {
                 oven = OvenState::ERROR;
-                up.stopTune(); lo.stopTune();
-                up.reset(); lo.reset();
+                for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].stopTune();
+                latchZoneError();
+                resetZones();
                 digitalWrite(Config::Pins::SAFETY_RELAY, LOW);
                 dirtySave(true);
             }
@@ -581,38 +2608,62 @@ void runControlTick(uint32_t now) {
 
         if (oven == OvenState::IDLE && askConfirmation == AskConfirmation::NONE) {
             oven = OvenState::PREHEAT;
-            up.reset(); lo.reset();
+            resetZones();
         }
 
-        // ヒーターを稼働させるステートの判定
-        bool isHeating = (oven != OvenState::REST && oven != OvenState::COOLING && 
-                          oven != OvenState::SHUTDOWN && oven != OvenState::ERROR
-                          && askConfirmation == AskConfirmation::NONE);
+        // ステートに応じた目標温度（停止系ステートでは0）
+        if (oven == OvenState::ECO) planEco();
+        // 予約時刻を過ぎても届かなければ通常の予熱に切り替える（無操作の計時は予約時刻から）
+        if (oven == OvenState::PLANNED && ReadyPlan::remainingS(now) <= 0.0f) { oven = OvenState::PREHEAT; lastActMs = now; }
+        if (oven == OvenState::PLANNED) ReadyPlan::update(now);
+        float upT, loT;
+        zoneTargets(upT, loT);
         
-        bool hUp = up.tick(isHeating ? r.upC : 0, settings.upHealth);
-        bool hLo = lo.tick(isHeating ? r.loC : 0, settings.loHealth);
+        bool lifeDue = false;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+            Config::Zones::Role role = Config::Zones::TABLE[i].role;
+            float outMax = (oven == OvenState::PLANNED) ? ReadyPlan::cap[role] * 255.0f : 255.0f;
+            lifeDue |= zones[i].tick(role == Config::Zones::BOTTOM ? loT : upT, settings.heaterCapC, outMax);
+        }
 
-        // 健康度の保存処理
-        if (hUp || hLo) {
-            if (f_abs(settings.upHealth - lastSavedUpHealth) >= 1.0f || f_abs(settings.loHealth - lastSavedLoHealth) >= 1.0f) {
-                dirtySave(true);
-                lastSavedUpHealth = settings.upHealth; lastSavedLoHealth = settings.loHealth;
-            }
+        // 寿命記録の保存（0.1%消耗ごと、または熱サイクル完了時）
+        if (lifeDue) saveLife();
+
+        // [投入/取り出し検知] 下火の生温度で変化点を判定
+        int8_t loadEv = loadDet.update(coldestC(Config::Zones::BOTTOM, true), coldestC(Config::Zones::TOP, true));
+        if (loadEv == LoadDetector::UNLOADED) meter.unload(loadDet.dwellS());
+
+        // [READY判定] 温度誤差が設定幅以内、かつ熱浸透度(Soak)が設定閾値以上
+        bool ready = true;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+            float ref = (Config::Zones::TABLE[i].role == Config::Zones::BOTTOM) ? r.loC() : r.upC();
+            ready &= f_abs(zones[i].plateC - ref) < settings.readyBandC && zones[i].soak > settings.soakReadyPct;
         }
 
-        // [READY判定] 温度誤差5度以内、かつ熱浸透度(Soak)が95%以上
-        bool ready = (f_abs(up.plateC - r.upC) < 5.0f && f_abs(lo.plateC - r.loC) < 5.0f && min(up.soak, lo.soak) > 95.0f);
+        // 予約予熱がREADYに届いたら通常の待機へ（営業開始時刻なので無操作の計時もここから）
+        if (oven == OvenState::PLANNED && ready) { oven = OvenState::READY; lastActMs = now; }
 
-        // [BAKE判定] READY状態でピザを投入（下火温度の急下降）した際に自動開始
+        // [BAKE判定] READY状態でピザの投入を検知した際に自動開始
         if (!baking && (oven == OvenState::PREHEAT || oven == OvenState::READY)) {
             oven = ready ? OvenState::READY : OvenState::PREHEAT;
-            if (ready && lo.trend < -2.0f) startBake(r.bakeSec);
+            if (ready) meter.ready(now); // 1枚分の計測を締める
+            if (ready && loadEv == LoadDetector::LOADED) startBake(r.bakeSec());
+            // 無操作が続いたら、すぐ戻れる温度でエコ保温
             if (now - lastActMs > Config::Hard::REST_TIMEOUT_MS) { 
-                oven = OvenState::REST; restStartMs = now; }
+                oven = OvenState::ECO; restStartMs = now; planEco(); storeModels(); }
+        }
+        // エコ保温が長時間続いた場合は従来の休止・冷却へ
+        if (oven == OvenState::ECO && now - lastActMs > Config::Hard::REST_TIMEOUT_MS + Config::Hard::ECO_MAX_MS) {
+            oven = OvenState::REST; restStartMs = now;
         }
 
         // 焼き上がり・メッセージ表示時間の管理
-        if (baking && (now - bakeStartMs >= curBakeSec * 1000UL)) { 
+        // [焼成熱量] 実温度から熱量を積算し、必要熱量に達したら終了（上下限あり）
+        if (baking) {
+            bakeRate = bakeHeatRate(r);
+            bakeDose += bakeRate;
+        }
+        if (baking && bakeRemainingS(now) == 0) { 
             baking = false; oven = OvenState::BAKE_DONE; bakeDoneMsgMs = now; 
         }
         if (oven == OvenState::BAKE_DONE && now - bakeDoneMsgMs > Config::Hard::BAKE_DONE_MSG_MS) 
@@ -620,7 +2671,8 @@ void runControlTick(uint32_t now) {
 
         // [冷却管理] 誤判定防止のため、安定して低温であることを確認して終了
         static uint32_t coolStableStart = 0;
-        bool cooledNow = (up.plateC < Config::Hard::COOL_COMPLETE_C && lo.plateC < Config::Hard::COOL_COMPLETE_C);
+        bool cooledNow = true;
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) cooledNow &= zones[i].plateC < Config::Hard::COOL_COMPLETE_C;
         if (!cooledNow) coolStableStart = 0;
         else if (coolStableStart == 0) coolStableStart = now;
         bool cooledConfirmed = (coolStableStart != 0 && now - coolStableStart > 2000UL);
@@ -632,7 +2684,7 @@ void runControlTick(uint32_t now) {
         else if (oven == OvenState::COOLING) {
             if (cooledConfirmed) {
                 if (now - bakeDoneMsgMs > 3000UL) { 
-                    oven = OvenState::SHUTDOWN; up.reset(); lo.reset(); coolStableStart = 0; dirtySave(true);
+                    oven = OvenState::SHUTDOWN; resetZones(); coolStableStart = 0; storeModels();
                 }
             } else {
                 bakeDoneMsgMs = now; // まだ熱い場合はタイマーをリセット（冷却完了から3秒後にOFFにするため）
@@ -640,11 +2692,14 @@ void runControlTick(uint32_t now) {
         }
 
         // [緊急停止] エラー発生時は全リセットし、安全リレーを遮断
-        if (up.error || lo.error) {
-            oven = OvenState::ERROR; up.reset(); lo.reset();
-            targetUpPWM = 0; targetLoPWM = 0;
+        if (anyZoneError()) {
+            powerLink.update(now, 0); // 協調相手へ電力枠を返却
+            latchZoneError();
+            oven = OvenState::ERROR; resetZones();
+            memset(targetPWM, 0, sizeof(targetPWM));
             digitalWrite(Config::Pins::SAFETY_RELAY, LOW);
             dirtySave(true);
+            saveWarmState(now); // リセットされてもERRORを維持する
             return;
         }
 
@@ -655,14 +2710,12 @@ void runControlTick(uint32_t now) {
 
 // シリアルプロッタ用テレメトリ出力
 void debugTelemetry(uint32_t now) {
+    CYCLE_PROBE(TELEM);
     static uint32_t lastLogMs = 0;
     if (now - lastLogMs >= 1000UL) {
         lastLogMs = now;
-        bool isHeating = oven != OvenState::REST && oven != OvenState::COOLING &&
-                         oven != OvenState::SHUTDOWN && oven != OvenState::ERROR;
-
-        float upSet = (oven == OvenState::TUNING) ? Config::Hard::TUNE_TARGET_C : (isHeating ? currentRecipe.upC : 0);
-        float loSet = (oven == OvenState::TUNING) ? Config::Hard::TUNE_TARGET_C : (isHeating ? currentRecipe.loC : 0);
+        float upSet, loSet;
+        zoneTargets(upSet, loSet);
         Serial.print(F("US:")); Serial.print(upSet);
         Serial.print(F(" LS:")); Serial.print(loSet);
         Serial.print(F(" UP:")); Serial.print(up.plateC);
@@ -673,73 +2726,117 @@ void debugTelemetry(uint32_t now) {
         Serial.print(F(" LW:")); Serial.print(targetLoPWM);
         Serial.print(F(" SK:")); Serial.print(min(up.soak, lo.soak));
         Serial.print(F(" ST:")); Serial.print((int)oven);
+        Serial.print(F(" RJ:")); Serial.print(up.rejects + lo.rejects);
+        Serial.print(F(" MF:")); Serial.print(memProbe.minFree);
+        Serial.print(F(" HU:")); Serial.print(memProbe.heapUsed);
+        Serial.print(F(" SD:")); Serial.print(memProbe.deepest());
+        Serial.print(F(" EU:")); Serial.print(meter.totalWh(meter.roleJ(Config::Zones::TOP)));
+        Serial.print(F(" EL:")); Serial.print(meter.totalWh(meter.roleJ(Config::Zones::BOTTOM)));
+        Serial.print(F(" WP:")); Serial.print(meter.lastWh10 / 10.0f);
+        Serial.print(F(" DR:")); Serial.print(meter.lastDrop10 / 10.0f);
+        Serial.print(F(" RC:")); Serial.print(meter.lastRecoverS);
+        Serial.print(F(" PH:")); Serial.print(meter.pizzasPerHour(now));
+        Serial.print(F(" PZ:")); Serial.print(meter.pizzas);
+        Serial.print(F(" DW:")); Serial.print(meter.lastDwellS);
+        Serial.print(F(" TF:")); Serial.print(up.tcFault | (lo.tcFault << 8)); // 熱電対アンプの異常（上火:下位8bit）
+        Serial.print(F(" EC:")); Serial.print(errorCause.bits | (errorCause.zone << 8)); // 最後のERRORの原因（error bit | ゾーン番号<<8）
+        if (oven == OvenState::PLANNED) { // 予約時刻までの秒数と、上火/下火の出力上限 [%]（開始前は0）
+            Serial.print(F(" RB:")); Serial.print(static_cast<uint32_t>(ReadyPlan::remainingS(now)));
+            Serial.print(F(" RU:")); Serial.print(ReadyPlan::cap[Config::Zones::TOP] * 100.0f, 0);
+            Serial.print(F(" RL:")); Serial.print(ReadyPlan::cap[Config::Zones::BOTTOM] * 100.0f, 0);
+        }
+        Serial.print(F(" LU:")); Serial.print(up.life.remainingH(settings.heaterCapC), 0);
+        Serial.print(F(" LL:")); Serial.print(lo.life.remainingH(settings.heaterCapC), 0);
+        if (Config::Link::ROLE != Config::Link::ROLE_STANDALONE) { Serial.print(F(" LB:")); Serial.print(powerLink.appliedW()); }
+        if (Config::Mains::SENSOR) {
+            // 主電源電流と、各ゾーンのフル出力時の換算電力（末尾!はセンサー異常で定格に戻した）
+            Serial.print(F(" MA:")); Serial.print(mains.avgA);
+            for (uint8_t i = 0; i < Config::Zones::CNT; i++) {
+                Serial.print(' '); Serial.print('W'); Serial.print(Config::Zones::TABLE[i].tag); Serial.print(':');
+                Serial.print(mains.fullW(i), 0);
+            }
+            if (mains.fault()) Serial.print('!');
+        }
         Serial.print(F(" LM:")); Config::Limit lim; memcpy_P(&lim, &Config::limits[settings.limitIdx], sizeof(lim)); Serial.println(lim.watts);
     }
 }
 
 void setup() {
+    MCUSR = 0; // WDRFが残っているとwdt_disableが効かない（リセット要因はCaterinaが消去済みのため見ない）
     wdt_disable(); // 初期化中のリセットを防ぐ
+    memProbe.paint(); // 空きRAMを計測用パターンで塗る
     Serial.begin(115200);
+    SPI.begin(); // 熱電対アンプ（各CSはコンストラクタでHIGHにしてある）
+    powerLink.begin();
     pinMode(Config::Pins::SAFETY_RELAY, OUTPUT); digitalWrite(Config::Pins::SAFETY_RELAY, LOW);
     pinMode(Config::Pins::ENC_CLK, INPUT_PULLUP); pinMode(Config::Pins::ENC_DT , INPUT_PULLUP); pinMode(Config::Pins::ENC_SW , INPUT_PULLUP);
 
     EEPROM.get(0, settings);
     if (settings.magic != Config::EEPROM_MAGIC) {
         // デフォルト値の設定（マジックナンバー排除）
-        settings = {
-            Config::EEPROM_MAGIC, 0, 0, 100.0f, 100.0f, 
-            3.5f, 0.05f, 1.0f, // UP PID Default
-            3.5f, 0.05f, 1.0f  // LO PID Default
-        }; 
+        settings = defaultSettings();
         EEPROM.put(0, settings);
+        RecipeOverlay::clear(); // 旧レイアウトのレシピ調整値が新しいレシピ番号に付かないように（工場出荷リセットと同じ）
     }
     lastSaveSettings = settings; // 初期状態を同期
-    lastSavedUpHealth = settings.upHealth;
-    lastSavedLoHealth = settings.loHealth;
+    loadLife();
 
-    up.setTunings(settings.upKp, settings.upKi, settings.upKd);
-    lo.setTunings(settings.loKp, settings.loKi, settings.loKd);
-    memcpy_P(&currentRecipe, &Config::recipes[settings.recipeIdx], sizeof(currentRecipe));
+    applyZoneSettings(true);
+    if (settings.recipeIdx >= Config::RECIPE_CNT) settings.recipeIdx = 0; // レシピ数が減った場合
+
+    // [ウォームリスタート] 保持状態が検証を通れば（電源投入以外のリセット）、スプラッシュを省いて即座に制御を再開
+    bool warm = restoreWarmState(millis());
 
     oled.begin(); // U8x8初期化
     
-    // 隠し機能: 起動時にボタン長押しでチューニングモードへ
-    if (digitalRead(Config::Pins::ENC_SW) == LOW) {
-        askConfirmation = AskConfirmation::START_TUNE;
-        confirmationYes = false;
-        while(digitalRead(Config::Pins::ENC_SW) == LOW) { delay(10); } // ボタンが離されるまで待機（誤操作防止）
-    }
+    if (!warm) {
+        // 隠し機能: 起動時にボタン長押しでチューニングモードへ
+        if (digitalRead(Config::Pins::ENC_SW) == LOW) {
+            askConfirmation = AskConfirmation::START_TUNE;
+            confirmationYes = false;
+            while(digitalRead(Config::Pins::ENC_SW) == LOW) { delay(10); } // ボタンが離されるまで待機（誤操作防止）
+        }
 
-    // ヒーター健康度（摩耗状態）を起動時に表示
-    oled.clear();
-    oled.setFont(u8x8_font_chroma48medium8_r);
-    oled.setCursor(2, 0); oled.print(F("HEATER HEALTH"));
-    oled.setCursor(0, 2); oled.print(F("UP : ")); oled.print(settings.upHealth, 1); oled.print(F("%"));
-    oled.setCursor(0, 4); oled.print(F("LO : ")); oled.print(settings.loHealth, 1); oled.print(F("%"));
-    // oled.display(); // U8x8は即時描画なので不要
-    delay(2000);
+        // ヒーターの残り寿命（健康度と時間）を起動時に表示
+        oled.clear();
+        oled.setFont(u8x8_font_chroma48medium8_r);
+        oled.setCursor(2, 0); oled.print(F("HEATER LIFE"));
+        oled.setCursor(0, 2); oled.print(F("UP ")); oled.print(100.0f * (1.0f - up.life.fraction()), 1); oled.print(F("% "));
+        oled.print((long)up.life.remainingH(settings.heaterCapC)); oled.print(F("h"));
+        oled.setCursor(0, 4); oled.print(F("LO ")); oled.print(100.0f * (1.0f - lo.life.fraction()), 1); oled.print(F("% "));
+        oled.print((long)lo.life.remainingH(settings.heaterCapC)); oled.print(F("h"));
+        // oled.display(); // U8x8は即時描画なので不要
+        delay(2000);
+        lastActMs = millis(); 
+    } else {
+        oled.clear();
+    }
 
     renderOLED(); 
-    digitalWrite(Config::Pins::SAFETY_RELAY, HIGH); // 安全回路を通電
-    lastActMs = millis(); 
+    // ERRORから復帰した場合は安全回路を遮断したまま
+    if (oven != OvenState::ERROR) digitalWrite(Config::Pins::SAFETY_RELAY, HIGH); // 安全回路を通電
     wdt_enable(WDTO_8S); // 8秒のウォッチドッグタイマーを設定
 }
 
 void loop() {
+    CYCLE_PROBE(LOOP);
     wdt_reset(); 
     uint32_t now = millis();
     
     handleInput(now);
+    Cmd::poll(now);
+    powerLink.poll(now);
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].sample(now);
     runControlTick(now);
 
-    if (oven == OvenState::ERROR) {
-        up.drive(0);
-        lo.drive(0);
-    } else {
-        if (oven == OvenState::TUNING && tuneStage == 1) targetLoPWM = 0;
-        if (oven == OvenState::TUNING && tuneStage == 3) targetUpPWM = 0;
-        up.drive(targetUpPWM); lo.drive(targetLoPWM);
-    }
+    // 直前の周期に出力していたSSRの組み合わせで電流を振り分ける
+    uint8_t onMask = 0;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) if (zones[i].ssrOn()) onMask |= 1 << i;
+    mains.sample(now, onMask);
+
+    if (oven == OvenState::TUNING)
+        for (uint8_t i = 0; i < Config::Zones::CNT; i++) if (i != tuneZone()) targetPWM[i] = 0;
+    for (uint8_t i = 0; i < Config::Zones::CNT; i++) zones[i].drive(oven == OvenState::ERROR ? 0 : targetPWM[i]);
 
     updateDisplay(now);
     dirtySave(); // 必要に応じて保存実行